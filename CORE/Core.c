@@ -0,0 +1,897 @@
+ /*======================================================================================================
+* FILE        : Core.c
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : One CU, ALU, MainMemory() and IOMemory() for the machines of LE2 - LE6. Which lab a
+*               binary behaves like is chosen when it is compiled (gcc -O2 -DLE=5 -o Core5 Core.c):
+*               LE picks a CU, memory, ALU and IO policy, and each policy can also be given on its
+*               own (-DMEMORY_POLICY=MEMORY_CHIPS ...). Policies are #if blocks, so a binary only holds
+*               the code of its configuration and the CU loop tests nothing at run time but the
+*               instruction code. The lab sources stay as they were handed in; the core does what
+*               they do, their bugs included (see the policies), and counts cycles with LE6's model
+*               for all of them. It runs headless: a program image in, the counts and registers out.
+*               PIPELINE_POLICY swaps the cycle model for a 3 or 5 stage pipeline (see pipelineIssue()),
+*               with a branch predictor picked at run time (-p). The instruction codes, cycle model,
+*               ALU and branch conditions of LE6 come from Core.h, which LE6 and the tools share.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+*   19 October, 2026: V1.1 - Pipelined timing model with hazard accounting (PIPELINE_POLICY)
+*   19 October, 2026: V1.2 - Branch predictors for the pipeline, accuracy per branch
+*   19 October, 2026: V1.3 - Instruction codes, cycles, ALU and branch conditions from Core.h
+*   19 October, 2026: V1.4 - Flat and chip memories from Memory.h
+======================================================================================================*/
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Core.h"
+#include "Memory.h"
+
+/*===============================================
+ *   POLICIES
+ *==============================================*/
+// CU: order of the register transfers
+#define CU_LE2 2        // registers move straight to and from dataMemory/ioBuffer, 2048 instructions at most
+#define CU_LAB 3        // LE3 - LE5: RM and RACC latch MBR from the bus before it is driven, RIO writes
+                        // the bus to the IO buffer and WIO reads it (RW is set the other way around),
+                        // SWAP copies IOBR into MBR and back, only BRLT compares (subtracts)
+#define CU_LE6 6
+
+// Memory backend
+#define MEMORY_ARRAY 1  // dataMemory[] indexed by the CU (LE2)
+#define MEMORY_BUS 2    // dataMemory[] behind MainMemory(), ADDR and BUS (LE3 - LE5)
+#define MEMORY_CHIPS 3  // chip groups A and B, a bit plane per chip, 0x400 and up in group B (LE6)
+
+// ALU
+#define ALU_NONE 0      // no ALU, WACC, RACC, SWAP and 0x11 - 0x1E are unused codes (LE2, LE3)
+#define ALU_LAB 1       // LE4, LE5: FLAGS is only ever tested against the SF/ZF variables, which
+                        // ALU() clears to 0, so every conditional branch is taken; the Booth product
+                        // is printed but not stored, MUL leaves ACC as it is
+#define ALU_LE6 2       // flags as in the TRACS, MUL stores the 16-bit product
+
+// IO
+#define IO_BUFFER 1     // ioBuffer[32] (LE2 - LE5)
+#define IO_DEVICES 2    // LE6's seven segment display at 0x000, latches at 0x001 - 0x00F and 0x013 -
+                        // 0x01F and an input stream without input; the interrupt controller, DMA,
+                        // timer, banks, counter and byte pipe are not modeled (their addresses
+                        // leave BUS as it is)
+
+// Timing
+#define PIPELINE_NONE 0 // instructionCycles[], one instruction at a time (every lab)
+#define PIPELINE_3 3    // IF ID EX, memory and IO accesses in EX
+#define PIPELINE_5 5    // IF ID EX MEM WB
+
+#ifndef LE
+#define LE 6
+#endif
+#if LE < 2 || LE > 6
+#error "LE must be 2 - 6"
+#endif
+#ifndef CU_POLICY
+#define CU_POLICY (LE == 2 ? CU_LE2 : LE == 6 ? CU_LE6 : CU_LAB)
+#endif
+#ifndef MEMORY_POLICY
+#define MEMORY_POLICY (LE == 2 ? MEMORY_ARRAY : LE == 6 ? MEMORY_CHIPS : MEMORY_BUS)
+#endif
+#ifndef ALU_POLICY
+#define ALU_POLICY (LE <= 3 ? ALU_NONE : LE == 6 ? ALU_LE6 : ALU_LAB)
+#endif
+#ifndef IO_POLICY
+#define IO_POLICY (LE == 6 ? IO_DEVICES : IO_BUFFER)
+#endif
+#ifndef PIPELINE_POLICY
+#define PIPELINE_POLICY PIPELINE_NONE
+#endif
+#if PIPELINE_POLICY != PIPELINE_NONE && PIPELINE_POLICY != PIPELINE_3 && PIPELINE_POLICY != PIPELINE_5
+#error "PIPELINE_POLICY must be PIPELINE_NONE, PIPELINE_3 or PIPELINE_5"
+#endif
+#ifndef FORWARDING
+#define FORWARDING 1    // pipeline results go straight to the stage that needs them; 0: registers are
+                        // read in ID and written in the last stage
+#endif
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define LE2_INSTRUCTIONS 2048   // CU() of LE2 is a for loop of 2048 instructions
+
+// CU() results
+#define RUN_EOP 1
+#define RUN_BUDGET 2
+
+#if PIPELINE_POLICY != PIPELINE_NONE
+#define STAGES PIPELINE_POLICY
+#define STAGE_IF 0              // 2 cycles on the bus, a byte each
+#define STAGE_ID 1
+#define STAGE_EX 2              // ALU, MBR to the ALU over the bus, conditional branches resolve here
+#define STAGE_MEM (STAGES == 5 ? 3 : STAGE_EX)
+#define BUS_WINDOW 256          // cycles of bus reservations kept, far more than an instruction spans
+
+// registers the pipeline tracks for data hazards
+#define REG_ACC 0x01
+#define REG_MBR 0x02
+#define REG_IOBR 0x04
+
+// stall causes
+#define STALL_BUS 0
+#define STALL_DATA 1
+#define STALL_CONTROL 2
+#define STALL_CAUSES 3
+
+// branch predictors
+#define PREDICT_NOT_TAKEN 0     // fetching goes on at PC + 2
+#define PREDICT_BACKWARD 1      // taken if the target is below the branch (loops)
+#define PREDICT_COUNTERS 2      // a 2-bit saturating counter per branch address
+#define PREDICT_GSHARE 3        // 2-bit counters indexed by the address XOR the global history
+#define PREDICTOR_ENTRIES 256   // default counters
+#define PREDICTOR_MAX_ENTRIES 65536
+#endif
+
+/*===============================================
+ *   GLOBAL VARIABLES
+ *==============================================*/
+unsigned int PC = 0, IR = 0, MAR = 0, MBR = 0, IOAR = 0, IOBR = 0;
+unsigned int ACC = 0, FLAGS = 0; // ACC is 32 bits wide like the labs' unsigned int
+unsigned char BUS = 0x00;        // 8 bit bus
+unsigned int ADDR = 0x00;
+bool IOM = 0;
+bool RW = 0;
+bool OE = 0;
+unsigned long long instructionCount = 0, cycleCount = 0;
+unsigned long long instructionBudget = ~0ull;
+
+#if MEMORY_POLICY == MEMORY_CHIPS
+long chips[2][CHIP_COUNT][CHIP_ROWS]; // [group A/B][chip 1 - 8 = bit 0 - 7 of a cell][row], bit n is column n
+long *const chipGroups[2][CHIP_COUNT] =
+{
+    {chips[0][0], chips[0][1], chips[0][2], chips[0][3], chips[0][4], chips[0][5], chips[0][6], chips[0][7]},
+    {chips[1][0], chips[1][1], chips[1][2], chips[1][3], chips[1][4], chips[1][5], chips[1][6], chips[1][7]}
+};
+#else
+unsigned char dataMemory[MEMORY_SIZE];
+#endif
+
+#if IO_POLICY == IO_BUFFER
+unsigned char ioBuffer[32];
+#else
+unsigned char iOData[32];
+unsigned long long segmentWrites = 0;
+#endif
+
+#if PIPELINE_POLICY != PIPELINE_NONE
+// what an instruction code reads and writes, and in which stage; bus is the stage that drives BUS
+typedef struct
+{
+    unsigned char reads, writes;
+    unsigned char use, produce, bus; // stages, 0 for none (IF is never one of them)
+} Stages;
+
+const Stages instructionStages[32] =
+{
+    [OP_WM] = {REG_MBR, 0, STAGE_MEM, 0, STAGE_MEM},
+    [OP_RM] = {0, REG_MBR, 0, STAGE_MEM, STAGE_MEM},
+    [OP_RIO] = {0, REG_IOBR, 0, STAGE_MEM, STAGE_MEM},
+    [OP_WIO] = {REG_IOBR, 0, STAGE_MEM, 0, STAGE_MEM},
+    [OP_WB] = {0, REG_MBR, 0, STAGE_EX, 0},
+    [OP_WIB] = {0, REG_IOBR, 0, STAGE_EX, 0},
+    [OP_WACC] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_RACC] = {REG_ACC, REG_MBR, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_SWAP] = {REG_MBR | REG_IOBR, REG_MBR | REG_IOBR, STAGE_EX, STAGE_EX, 0},
+    [OP_BRLT] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_BRGT] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_BRNE] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_BRE] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_SHR] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_SHL] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_XOR] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_NOT] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_OR] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_AND] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_MUL] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_SUB] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX},
+    [OP_ADD] = {REG_ACC | REG_MBR, REG_ACC, STAGE_EX, STAGE_EX, STAGE_EX}
+};
+
+unsigned long long busReserved[BUS_WINDOW];     // cycle + 1 of the reservation in busReserved[cycle % BUS_WINDOW]
+unsigned long long previousStages[STAGES + 1];  // cycles the last instruction entered each stage and left WB
+unsigned long long registerReady[REG_IOBR + 1]; // first cycle a register can be used, by its REG_ bit
+unsigned long long fetchFrom = 0;               // first cycle of the next fetch after a jump
+unsigned long long stallCycles[STALL_CAUSES], hazards[STALL_CAUSES];
+
+// branch prediction
+typedef struct
+{
+    unsigned long long executed, taken, predicted; // predicted: the prediction was right
+} BranchStats;
+
+const char *predictorNames[] = {"not-taken", "backward", "2bit", "gshare"};
+unsigned int predictor = PREDICT_NOT_TAKEN;
+unsigned int predictorMask = PREDICTOR_ENTRIES - 1, historyMask = PREDICTOR_ENTRIES - 1, history = 0;
+unsigned char counters[PREDICTOR_MAX_ENTRIES]; // 0, 1 predict not taken, 2, 3 taken
+BranchStats branchStats[MEMORY_SIZE];          // by the address of the branch
+#endif
+
+/*===============================================
+ *   FUNCTION PROTOTYPES
+ *==============================================*/
+int CU(void);
+int loadImage(const char *path);
+void MainMemory(void);
+void IOMemory(void);
+void ALU(unsigned int control);
+#if PIPELINE_POLICY != PIPELINE_NONE
+void pipelineIssue(unsigned int inst_code, unsigned int address, unsigned int target, bool taken);
+unsigned long long busCycle(unsigned long long from);
+int predictorConfigure(const char *spec);
+bool branchPredict(unsigned int address, unsigned int target);
+void branchUpdate(unsigned int address, bool taken);
+void printBranches(void);
+#endif
+
+/*===============================================
+ *   POLICY FUNCTIONS
+ *==============================================*/
+#if MEMORY_POLICY == MEMORY_ARRAY
+static inline unsigned char memoryRead(unsigned int address)
+{
+    return flatRead(dataMemory, address);
+}
+
+static inline void memoryWrite(unsigned int address, unsigned char data)
+{
+    flatWrite(dataMemory, address, data);
+}
+#else
+static inline unsigned char memoryRead(unsigned int address)
+{
+    IOM = 1, RW = 0, OE = 1;
+    ADDR = address;
+    MainMemory();
+    return BUS;
+}
+
+static inline void memoryWrite(unsigned int address, unsigned char data)
+{
+    IOM = 1, RW = 1, OE = 1;
+    ADDR = address;
+    BUS = data;
+    MainMemory();
+}
+#endif
+
+static inline unsigned char ioRead(unsigned int address)
+{
+    IOM = 0, RW = 0, OE = 1;
+    ADDR = address;
+    IOMemory();
+    return BUS;
+}
+
+static inline void ioWrite(unsigned int address, unsigned char data)
+{
+    IOM = 0, RW = 1, OE = 1;
+    ADDR = address;
+    BUS = data;
+    IOMemory();
+}
+
+#if ALU_POLICY == ALU_LAB
+#define branchTaken(inst_code) true // (FLAGS & SF) == SF with SF = 0, and so on
+#else
+#define branchTaken(inst_code) coreBranchTaken(inst_code, FLAGS)
+#endif
+
+/*===============================================
+*   FUNCTION    :   MAIN
+*   DESCRIPTION :   Loads the image, runs it and prints the counts and the
+*                   registers.
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 at EOP, 1 on errors, 2 when the budget ran out)
+ *==============================================*/
+int main(int argc, char *argv[])
+{
+    const char *image = NULL;
+    int i, result;
+
+#if CU_POLICY == CU_LE2
+    instructionBudget = LE2_INSTRUCTIONS;
+#endif
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            instructionBudget = strtoull(argv[++i], NULL, 0);
+#if PIPELINE_POLICY != PIPELINE_NONE
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            if(predictorConfigure(argv[++i]) != 1)
+                return 1;
+        }
+#endif
+        else if(argv[i][0] == '-' || image != NULL)
+        {
+            image = NULL;
+            break;
+        }
+        else
+            image = argv[i];
+    }
+    if(image == NULL)
+    {
+#if PIPELINE_POLICY == PIPELINE_NONE
+        printf("Usage: %s [-i instructions] image.bin\n", argv[0]);
+#else
+        printf("Usage: %s [-i instructions] [-p predictor[,entries[,history]]] image.bin\n", argv[0]);
+        printf("Predictors: not-taken (default), backward, 2bit, gshare; %d counters by default\n", PREDICTOR_ENTRIES);
+#endif
+        printf("LE%d semantics: CU %d, memory %d, ALU %d, IO %d\n", LE, CU_POLICY, MEMORY_POLICY, ALU_POLICY, IO_POLICY);
+        return 1;
+    }
+    if(loadImage(image) != 1)
+        return 1;
+
+    result = CU();
+    if(result == RUN_EOP)
+        printf("Program ran successfully!\n");
+    else
+        printf("The program was terminated after encountering an error.\n");
+    printf("%llu instructions, %llu cycles\n", instructionCount, cycleCount);
+    printf("PC 0x%03x, ACC 0x%08x, FLAGS 0x%02x, MBR 0x%03x, IOBR 0x%03x, BUS 0x%02x\n", PC, ACC, FLAGS, MBR, IOBR, BUS);
+#if IO_POLICY == IO_DEVICES
+    if(segmentWrites > 0)
+        printf("Seven segment: %llu writes, last 0x%02x\n", segmentWrites, iOData[IO_SEGMENT]);
+#endif
+#if PIPELINE_POLICY != PIPELINE_NONE
+    printf("Pipeline: %d stages, CPI %.3f, %llu stall cycles (bus %llu, data %llu, control %llu)\n", STAGES,
+           instructionCount ? (double)cycleCount / instructionCount : 0.0, stallCycles[STALL_BUS] + stallCycles[STALL_DATA]
+           + stallCycles[STALL_CONTROL], stallCycles[STALL_BUS], stallCycles[STALL_DATA], stallCycles[STALL_CONTROL]);
+    printf("Hazards: %llu bus conflicts, %llu data, %llu control\n", hazards[STALL_BUS], hazards[STALL_DATA],
+           hazards[STALL_CONTROL]);
+    printBranches();
+#endif
+    return result == RUN_EOP ? 0 : 2;
+}
+
+/*===============================================
+*   FUNCTION    :   CU
+*   DESCRIPTION :   Fetches, decodes and executes instructions up to EOP or
+*                   the instruction budget. Unused codes do nothing, like in
+*                   every lab (RETI too, there is no interrupt to return from).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   INT (RUN_EOP or RUN_BUDGET)
+ *==============================================*/
+int CU(void)
+{
+    unsigned int inst_code, operand;
+#if PIPELINE_POLICY != PIPELINE_NONE
+    unsigned int address;
+    bool taken;
+#endif
+
+    while(instructionCount < instructionBudget)
+    {
+        /* fetch, the upper byte first */
+#if PIPELINE_POLICY != PIPELINE_NONE
+        address = PC;
+#endif
+        IR = memoryRead(PC) << 8;
+        IR |= memoryRead(PC + 1);
+        PC += 2;
+        inst_code = IR >> 11;
+        operand = IR & OPERAND_MASK;
+        instructionCount++;
+#if PIPELINE_POLICY == PIPELINE_NONE
+        cycleCount += coreCycles[inst_code];
+#else
+        taken = false;
+#endif
+
+        switch(inst_code)
+        {
+            case OP_WM:
+                MAR = operand;
+                memoryWrite(MAR, (unsigned char)MBR);
+                break;
+            case OP_RM:
+                MAR = operand;
+#if CU_POLICY == CU_LAB
+                MBR = BUS; // before MainMemory() puts the cell on the bus
+                memoryRead(MAR);
+#else
+                MBR = memoryRead(MAR);
+#endif
+                break;
+            case OP_BR:
+                PC = operand;
+#if PIPELINE_POLICY != PIPELINE_NONE
+                taken = true;
+#endif
+                break;
+            case OP_RIO:
+                IOAR = operand;
+#if CU_POLICY == CU_LAB
+                ioWrite(IOAR, BUS);
+#else
+                IOBR = ioRead(IOAR);
+#endif
+                break;
+            case OP_WIO:
+                IOAR = operand;
+#if CU_POLICY == CU_LAB
+                ioRead(IOAR);
+#else
+                ioWrite(IOAR, (unsigned char)IOBR);
+#endif
+                break;
+            case OP_WB:
+                MBR = operand;
+                break;
+            case OP_WIB:
+                IOBR = operand;
+                break;
+#if ALU_POLICY != ALU_NONE
+            case OP_WACC:
+                BUS = (unsigned char)MBR;
+                ALU(OP_WACC);
+                break;
+            case OP_RACC:
+#if CU_POLICY == CU_LAB
+                MBR = BUS;
+                ALU(OP_RACC);
+#else
+                ALU(OP_RACC);
+                MBR = BUS;
+#endif
+                break;
+            case OP_SWAP:
+            {
+#if CU_POLICY == CU_LAB
+                MBR = IOBR;
+#else
+                unsigned int temp = IOBR;
+
+                IOBR = MBR;
+                MBR = temp;
+#endif
+                break;
+            }
+            case OP_BRLT: case OP_BRGT: case OP_BRNE: case OP_BRE:
+                BUS = (unsigned char)MBR;
+#if CU_POLICY == CU_LAB
+                ALU(inst_code == OP_BRLT ? OP_SUB : inst_code);
+#else
+                ALU(OP_SUB); // compare: ACC <- ACC - BUS
+#endif
+                if(branchTaken(inst_code))
+                {
+                    PC = operand;
+#if PIPELINE_POLICY != PIPELINE_NONE
+                    taken = true;
+#endif
+                }
+                break;
+            case OP_SHR: case OP_SHL: case OP_XOR: case OP_NOT: case OP_OR: case OP_AND:
+            case OP_MUL: case OP_SUB: case OP_ADD:
+                BUS = (unsigned char)MBR;
+                ALU(inst_code);
+                break;
+#endif
+            case OP_EOP:
+#if PIPELINE_POLICY != PIPELINE_NONE
+                pipelineIssue(inst_code, address, operand, false);
+#endif
+                return RUN_EOP;
+            default:
+                break;
+        }
+#if PIPELINE_POLICY != PIPELINE_NONE
+        pipelineIssue(inst_code, address, operand, taken);
+#endif
+    }
+    return RUN_BUDGET;
+}
+
+/*===============================================
+*   FUNCTION    :   loadImage
+*   DESCRIPTION :   Loads a binary program image into main memory, byte n of
+*                   the file going to address n.
+*   ARGUMENTS   :   const char *path
+*   RETURNS     :   INT (1 if the image was loaded, 0 otherwise)
+ *==============================================*/
+int loadImage(const char *path)
+{
+    unsigned char image[MEMORY_SIZE];
+    size_t size, i;
+    FILE *fp = fopen(path, "rb");
+
+    if(fp == NULL)
+    {
+        printf("Error: cannot open image %s\n", path);
+        return 0;
+    }
+    size = fread(image, 1, sizeof(image), fp);
+    if(fgetc(fp) != EOF)
+    {
+        printf("Error: image %s is larger than the %d byte main memory\n", path, MEMORY_SIZE);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    for(i = 0; i < size; i++)
+        memoryWrite((unsigned int)i, image[i]);
+    BUS = 0x00;
+    return 1;
+}
+
+#if MEMORY_POLICY == MEMORY_BUS
+/*===============================================
+*   FUNCTION    :   MainMemory
+*   DESCRIPTION :   Reads or writes the flat memory at ADDR through BUS.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void MainMemory(void)
+{
+    if(IOM == 1 && OE == 1)
+    {
+        if(RW == 0) // memory read
+            BUS = flatRead(dataMemory, ADDR);
+        else // memory write
+            flatWrite(dataMemory, ADDR, BUS);
+    }
+}
+#elif MEMORY_POLICY == MEMORY_CHIPS
+/*===============================================
+*   FUNCTION    :   MainMemory
+*   DESCRIPTION :   Reads or writes a cell of the chips at ADDR through BUS
+*                   (chipRead()/chipWrite() of Memory.h, as in LE6). cs =
+*                   ADDR >> 10 picks group B for 0x400 and up.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void MainMemory(void)
+{
+    unsigned int cs = (ADDR >> 10) != 0;
+
+    if(IOM == 1 && OE == 1)
+    {
+        if(RW == 0) // memory read
+            BUS = chipRead(chipGroups[cs], ADDR);
+        else // memory write
+            chipWrite(chipGroups[cs], ADDR, BUS);
+    }
+}
+#endif
+
+#if IO_POLICY == IO_BUFFER
+/*===============================================
+*   FUNCTION    :   IOMemory
+*   DESCRIPTION :   Reads or writes ioBuffer at ADDR through BUS. Addresses
+*                   past the buffer (out of its bounds in the labs) leave
+*                   everything as is.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void IOMemory(void)
+{
+    if(IOM == 0 && OE == 1 && ADDR < sizeof(ioBuffer))
+    {
+        if(RW == 0) // IO read
+            BUS = ioBuffer[ADDR];
+        else // IO write
+            ioBuffer[ADDR] = BUS;
+    }
+}
+#else
+/*===============================================
+*   FUNCTION    :   IOMemory
+*   DESCRIPTION :   The IO addresses of LE6 this core models. The input
+*                   stream has no input: no byte, end of input.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void IOMemory(void)
+{
+    if(IOM == 1 || OE == 0)
+        return;
+    if(RW == 1) // IO write
+    {
+        if(ADDR == IO_SEGMENT)
+            segmentWrites++;
+        if(ADDR < IO_INPUT_DATA)
+            iOData[ADDR] = BUS;
+    }
+    else if(ADDR == IO_INPUT_STATUS)
+        BUS = IO_INPUT_END;
+    else if(ADDR == IO_INPUT_DATA || ADDR == IO_INPUT_COUNT)
+        BUS = 0x00;
+    else if(ADDR >= IO_INPUT_LATCHES && ADDR <= IO_LAST_LATCH)
+        BUS = iOData[ADDR];
+}
+#endif
+
+#if ALU_POLICY != ALU_NONE
+/*===============================================
+*   FUNCTION    :   ALU
+*   DESCRIPTION :   coreALU() on ACC, BUS and FLAGS. ALU_LAB keeps FLAGS of
+*                   its own (LE4 and LE5 never set the register) and leaves
+*                   ACC as it is on MUL.
+*   ARGUMENTS   :   UNSIGNED INT control (instruction code of the operation)
+*   RETURNS     :   VOID
+ *==============================================*/
+void ALU(unsigned int control)
+{
+#if ALU_POLICY == ALU_LE6
+    coreALU(control, &ACC, &BUS, &FLAGS, coreBooth);
+#else
+    unsigned int flags = 0;
+
+    coreALU(control, &ACC, &BUS, &flags, NULL);
+#endif
+}
+#endif
+
+#if PIPELINE_POLICY != PIPELINE_NONE
+/*===============================================
+*   FUNCTION    :   pipelineIssue
+*   DESCRIPTION :   Times an instruction CU() has just executed through the
+*                   pipeline and sets cycleCount to the cycle after it leaves
+*                   WB. CU() still executes one instruction at a time, the
+*                   pipeline only decides when each stage happens: in order,
+*                   a stage per cycle, an instruction entering a stage once
+*                   the one before it has left it. It waits for
+*                     the bus: BUS is 8 bits, so IF takes 2 cycles, and the
+*                       stage that drives BUS (instructionStages[]) takes
+*                       the cycle from younger fetches, older instructions
+*                       first
+*                     data: a stage that reads ACC, MBR or IOBR waits for
+*                       the stage that writes it to end (with FORWARDING,
+*                       in 5 stages only RM, RIO -> use can stall)
+*                     control: the target of a jump is in its own word,
+*                       so IF can jump once it has both bytes. BR always
+*                       does; BRLT/BRGT/BRNE/BRE ask the predictor, and go
+*                       on at PC + 2 if it says not taken. A wrong guess
+*                       refetches after EX, dropping what was fetched
+*                   The cycles an instruction leaves WB after the one before
+*                   it, minus one, are its stall cycles, given to the causes
+*                   it waited for, control first, then data, then the bus.
+*   ARGUMENTS   :   UNSIGNED INT inst_code, UNSIGNED INT address (of the
+*                   instruction), UNSIGNED INT target (operand), BOOL taken
+*                   (the branch jumped)
+*   RETURNS     :   VOID
+ *==============================================*/
+void pipelineIssue(unsigned int inst_code, unsigned int address, unsigned int target, bool taken)
+{
+    const Stages *stages = &instructionStages[inst_code];
+    unsigned long long enter[STAGES + 1], end, t, ready, cycle, waits[STALL_CAUSES] = {0, 0, 0}, gap, take;
+    unsigned long long endIF, endEX = 0;
+    unsigned int reg, s, use = stages->use, produce = stages->produce;
+    int cause;
+
+#if !FORWARDING
+    use = stages->reads ? STAGE_ID : 0;
+    produce = stages->writes ? STAGES - 1 : 0;
+#endif
+
+    /* IF, once the previous instruction is in ID and after a jump */
+    t = previousStages[STAGE_ID];
+    if(fetchFrom > t)
+    {
+        waits[STALL_CONTROL] = fetchFrom - t;
+        hazards[STALL_CONTROL]++;
+        t = fetchFrom;
+    }
+    enter[STAGE_IF] = t;
+    cycle = busCycle(t); // upper byte
+    end = busCycle(cycle + 1); // lower byte
+    waits[STALL_BUS] = end - t;
+    if(end - t > 1)
+        hazards[STALL_BUS]++;
+    endIF = ++end;
+
+    for(s = STAGE_ID; s < STAGES; s++)
+    {
+        t = end > previousStages[s + 1] ? end : previousStages[s + 1];
+        if(s == use)
+        {
+            for(reg = REG_ACC, ready = 0; reg <= REG_IOBR; reg <<= 1)
+            {
+                if((stages->reads & reg) && registerReady[reg] > ready)
+                    ready = registerReady[reg];
+            }
+            if(ready > t)
+            {
+                waits[STALL_DATA] += ready - t;
+                hazards[STALL_DATA]++;
+                t = ready;
+            }
+        }
+        enter[s] = t;
+        end = t + 1;
+        if(s == stages->bus)
+        {
+            cycle = busCycle(t);
+            if(cycle > t)
+            {
+                waits[STALL_BUS] += cycle - t;
+                hazards[STALL_BUS]++;
+            }
+            end = cycle + 1;
+        }
+        if(s == produce)
+        {
+            for(reg = REG_ACC; reg <= REG_IOBR; reg <<= 1)
+            {
+                if(stages->writes & reg)
+                    registerReady[reg] = end;
+            }
+        }
+        if(s == STAGE_EX)
+            endEX = end;
+    }
+    enter[STAGES] = end;
+
+    /* the next fetch */
+    fetchFrom = 0;
+    if(inst_code == OP_BR)
+        fetchFrom = endIF;
+    else if(inst_code >= OP_BRLT && inst_code <= OP_BRE)
+    {
+        bool predicted = branchPredict(address, target);
+
+        if(predicted != taken)
+            fetchFrom = endEX;
+        else if(taken)
+            fetchFrom = endIF;
+        branchUpdate(address, taken);
+        branchStats[address & ADDRESS_MASK].executed++;
+        branchStats[address & ADDRESS_MASK].taken += taken;
+        branchStats[address & ADDRESS_MASK].predicted += predicted == taken;
+    }
+
+    /* stall cycles of this instruction */
+    gap = end - (instructionCount == 1 ? STAGES : previousStages[STAGES] + 1);
+    for(cause = STALL_CONTROL; cause >= STALL_BUS && gap > 0; cause--)
+    {
+        take = waits[cause] < gap ? waits[cause] : gap;
+        stallCycles[cause] += take;
+        gap -= take;
+    }
+    stallCycles[STALL_BUS] += gap; // nothing left unless the waits missed a cause
+    cycleCount = end;
+    memcpy(previousStages, enter, sizeof(enter));
+}
+
+/*===============================================
+*   FUNCTION    :   busCycle
+*   DESCRIPTION :   Reserves the first cycle from a given one that no older
+*                   instruction has the bus in.
+*   ARGUMENTS   :   UNSIGNED LONG LONG from
+*   RETURNS     :   UNSIGNED LONG LONG (the cycle)
+ *==============================================*/
+unsigned long long busCycle(unsigned long long from)
+{
+    while(busReserved[from % BUS_WINDOW] == from + 1)
+        from++;
+    busReserved[from % BUS_WINDOW] = from + 1;
+    return from;
+}
+#endif
+
+#if PIPELINE_POLICY != PIPELINE_NONE
+/*===============================================
+*   FUNCTION    :   predictorConfigure
+*   DESCRIPTION :   Picks the branch predictor from "name[,entries[,history]]":
+*                   not-taken, backward, 2bit or gshare, entries counters (a
+*                   power of two) and history bits of gshare (as many as
+*                   index the counters by default). The counters start at
+*                   1, weakly not taken.
+*   ARGUMENTS   :   const char *spec
+*   RETURNS     :   INT (1 if the predictor was set up, 0 otherwise)
+ *==============================================*/
+int predictorConfigure(const char *spec)
+{
+    unsigned int entries = PREDICTOR_ENTRIES, bits = 0, i;
+    char name[16] = "";
+    int fields = sscanf(spec, "%15[^,],%u,%u", name, &entries, &bits);
+
+    for(predictor = 0; predictor < sizeof(predictorNames) / sizeof(predictorNames[0]); predictor++)
+    {
+        if(strcmp(name, predictorNames[predictor]) == 0)
+            break;
+    }
+    if(fields < 1 || predictor == sizeof(predictorNames) / sizeof(predictorNames[0]) || entries == 0
+       || entries > PREDICTOR_MAX_ENTRIES || (entries & (entries - 1)) || bits > 16)
+    {
+        printf("Error: -p needs not-taken, backward, 2bit or gshare[,entries[,history]] with a power of two of at most "
+               "%d entries, got %s\n", PREDICTOR_MAX_ENTRIES, spec);
+        return 0;
+    }
+    predictorMask = entries - 1;
+    historyMask = fields == 3 ? (1u << bits) - 1 : predictorMask;
+    for(i = 0; i < entries; i++)
+        counters[i] = 1;
+    return 1;
+}
+
+/*===============================================
+*   FUNCTION    :   branchPredict
+*   DESCRIPTION :   Guess of the predictor for a conditional branch.
+*   ARGUMENTS   :   UNSIGNED INT address (of the branch), UNSIGNED INT target
+*   RETURNS     :   BOOL (true if taken)
+ *==============================================*/
+bool branchPredict(unsigned int address, unsigned int target)
+{
+    switch(predictor)
+    {
+        case PREDICT_BACKWARD:
+            return target < address;
+        case PREDICT_COUNTERS:
+            return counters[(address >> 1) & predictorMask] >= 2;
+        case PREDICT_GSHARE:
+            return counters[((address >> 1) ^ (history & historyMask)) & predictorMask] >= 2;
+        default:
+            return false;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   branchUpdate
+*   DESCRIPTION :   Trains the counters (and the history of gshare) on what a
+*                   branch did. Instructions are 2 bytes, so the counters are
+*                   indexed by address / 2.
+*   ARGUMENTS   :   UNSIGNED INT address, BOOL taken
+*   RETURNS     :   VOID
+ *==============================================*/
+void branchUpdate(unsigned int address, bool taken)
+{
+    unsigned char *counter;
+
+    if(predictor == PREDICT_COUNTERS)
+        counter = &counters[(address >> 1) & predictorMask];
+    else if(predictor == PREDICT_GSHARE)
+        counter = &counters[((address >> 1) ^ (history & historyMask)) & predictorMask];
+    else
+        return;
+    if(taken && *counter < 3)
+        (*counter)++;
+    else if(!taken && *counter > 0)
+        (*counter)--;
+    history = (history << 1) | taken;
+}
+
+/*===============================================
+*   FUNCTION    :   printBranches
+*   DESCRIPTION :   Accuracy of the predictor, overall and per branch.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void printBranches(void)
+{
+    unsigned long long executed = 0, predicted = 0;
+    unsigned int address;
+
+    for(address = 0; address < MEMORY_SIZE; address++)
+    {
+        executed += branchStats[address].executed;
+        predicted += branchStats[address].predicted;
+    }
+    if(executed == 0)
+        return;
+    printf("Predictor %s: %llu of %llu branches right (%.2f%%), %llu mispredicted\n", predictorNames[predictor], predicted,
+           executed, 100.0 * predicted / executed, executed - predicted);
+    for(address = 0; address < MEMORY_SIZE; address++)
+    {
+        const BranchStats *branch = &branchStats[address];
+
+        if(branch->executed > 0)
+            printf("  0x%03x: %llu executed, %.2f%% taken, %.2f%% right\n", address, branch->executed,
+                   100.0 * branch->taken / branch->executed, 100.0 * branch->predicted / branch->executed);
+    }
+}
+#endif
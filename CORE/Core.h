@@ -0,0 +1,214 @@
+ /*======================================================================================================
+* FILE        : Core.h
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : The machine of LE6 as every program of the bin runs it: instruction codes, FLAGS
+*               bits, the cycle model, the ALU with its flags, Booth's algorithm and the branch
+*               conditions. LE6, CORE/Core.c, FaultCampaign and BitSlice include it instead of
+*               keeping their own copies. The functions are static inline and take the registers
+*               as arguments, so each program keeps its registers where it has them (globals in
+*               LE6 and the core, a Machine in FaultCampaign) and pays no call.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+======================================================================================================*/
+#ifndef CORE_H
+#define CORE_H
+
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#include <stdbool.h>
+#include <stddef.h>
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define MEMORY_SIZE 2048        // 11-bit address space of the main memory
+#define ADDRESS_MASK 0x07FF     // PC past 0x7FF wraps on the flat memories
+#define OPERAND_MASK 0x07FF     // lower 11 bits of IR
+
+// FLAGS register bits (OF - - - - SF CF ZF)
+#define ZF_MASK 0x01
+#define CF_MASK 0x02
+#define SF_MASK 0x04
+#define OF_MASK 0x80
+
+// Instruction codes
+#define OP_WM 0x01
+#define OP_RM 0x02
+#define OP_BR 0x03
+#define OP_RIO 0x04
+#define OP_WIO 0x05
+#define OP_WB 0x06
+#define OP_WIB 0x07
+#define OP_RETI 0x08
+#define OP_WACC 0x09
+#define OP_RACC 0x0B
+#define OP_SWAP 0x0E
+#define OP_BRLT 0x11
+#define OP_BRGT 0x12
+#define OP_BRNE 0x13
+#define OP_BRE 0x14
+#define OP_SHR 0x15
+#define OP_SHL 0x16
+#define OP_XOR 0x17
+#define OP_NOT 0x18
+#define OP_OR 0x19
+#define OP_AND 0x1A
+#define OP_MUL 0x1B
+#define OP_SUB 0x1D
+#define OP_ADD 0x1E
+#define OP_EOP 0x1F
+
+// IO addresses of the seven segment display and the input stream, the devices the headless
+// runners model (LE6 has the whole device set, see IOInit())
+#define IO_SEGMENT 0x000
+#define IO_OUTPUT_LATCHES 0x001 // 0x001 - 0x00F
+#define IO_INPUT_DATA 0x010
+#define IO_INPUT_STATUS 0x011
+#define IO_INPUT_COUNT 0x012
+#define IO_INPUT_LATCHES 0x013  // 0x013 - 0x01F
+#define IO_LAST_LATCH 0x01F
+#define IO_INPUT_END 0x02       // IO_INPUT_STATUS bit of the end of input
+
+// Cycles of every instruction code: 2 fetch cycles (upper and lower byte) plus the execute
+// cycles of TRACS figure 4, 2 for ALU operations (BUS <- MBR, ACC <- ACC op BUS) and 1 for data
+// movement and branches. Unused codes only fetch.
+static const unsigned char coreCycles[32] =
+{
+    2, 3, 3, 3, 3, 3, 3, 3, 3, 4, 2, 4, 2, 2, 3, 2,
+    2, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 2, 4, 4, 3
+};
+
+/*===============================================
+*   FUNCTION    :   coreBoothStep
+*   DESCRIPTION :   One step of Booth's algorithm as in the labs: add -M or M
+*                   on 10 or 01, then shift A, Q and Q-1 right (the bit
+*                   shifted into Q is the LSB of A before the addition).
+*   ARGUMENTS   :   UNSIGNED CHAR *A, UNSIGNED CHAR *Q, UNSIGNED CHAR *Q_N1,
+*                   UNSIGNED CHAR M (multiplicand)
+*   RETURNS     :   VOID
+ *==============================================*/
+static inline void coreBoothStep(unsigned char *A, unsigned char *Q, unsigned char *Q_N1, unsigned char M)
+{
+    unsigned char LSB_Q = *Q & 0x01, LSB_A = *A & 0x01;
+
+    if(LSB_Q == 1 && *Q_N1 == 0)
+        *A = *A + (unsigned char)(~M + 1);
+    else if(LSB_Q == 0 && *Q_N1 == 1)
+        *A = *A + M;
+    *A = (unsigned char)((*A >> 1) | (*A & 0x80));
+    *Q = (unsigned char)((*Q >> 1) | (LSB_A << 7));
+    *Q_N1 = LSB_Q;
+}
+
+/*===============================================
+*   FUNCTION    :   coreBooth
+*   DESCRIPTION :   Booth's algorithm, the 8 steps of coreBoothStep().
+*   ARGUMENTS   :   UNSIGNED CHAR M (multiplicand), UNSIGNED CHAR Q (multiplier)
+*   RETURNS     :   UNSIGNED INT (16-bit product)
+ *==============================================*/
+static inline unsigned int coreBooth(unsigned char M, unsigned char Q)
+{
+    unsigned char A = 0, Q_N1 = 0;
+    int n;
+
+    for(n = 0; n < 8; n++)
+        coreBoothStep(&A, &Q, &Q_N1, M);
+    return (A << 8) | Q;
+}
+
+/*===============================================
+*   FUNCTION    :   coreALU
+*   DESCRIPTION :   Operates on ACC and BUS. ADD and SUB work on the low byte
+*                   of ACC, the logic operations and shifts on all of it, MUL
+*                   stores the product of the low byte of ACC and BUS. Only
+*                   the FLAGS bits an operation affects are updated (TRACS):
+*                   all four by ADD, SUB and MUL, ZF by the logic operations
+*                   and CF by the shifts. Other codes do nothing.
+*   ARGUMENTS   :   UNSIGNED INT control (instruction code of the operation),
+*                   UNSIGNED INT *acc, UNSIGNED CHAR *bus, UNSIGNED INT *flags,
+*                   multiply (Booth's algorithm; NULL: MUL leaves ACC and
+*                   FLAGS as they are, like LE4 and LE5)
+*   RETURNS     :   VOID
+ *==============================================*/
+static inline void coreALU(unsigned int control, unsigned int *acc, unsigned char *bus, unsigned int *flags,
+                           unsigned int (*multiply)(unsigned char M, unsigned char Q))
+{
+    unsigned int op1, op2, sum, affected = 0, set = 0;
+
+    switch(control)
+    {
+        case OP_ADD: case OP_SUB:
+            op1 = *acc & 0xFF;
+            op2 = control == OP_SUB ? (unsigned char)(~*bus + 1) : *bus;
+            sum = op1 + op2;
+            *acc = sum & 0xFF;
+            affected = ZF_MASK | CF_MASK | SF_MASK | OF_MASK;
+            set = (*acc == 0 ? ZF_MASK : 0) | (sum > 0xFF ? CF_MASK : 0) | (*acc & 0x80 ? SF_MASK : 0)
+                  | ((op1 ^ *acc) & (op2 ^ *acc) & 0x80 ? OF_MASK : 0);
+            break;
+        case OP_MUL:
+            if(multiply == NULL)
+                break;
+            *acc = multiply((unsigned char)*acc, *bus);
+            affected = ZF_MASK | CF_MASK | SF_MASK | OF_MASK;
+            set = (*acc == 0 ? ZF_MASK : 0) | (*acc & 0x8000 ? SF_MASK : 0) | (*acc > 0xFF ? CF_MASK | OF_MASK : 0);
+            break;
+        case OP_AND: case OP_OR: case OP_XOR: case OP_NOT:
+            if(control == OP_AND)
+                *acc &= *bus;
+            else if(control == OP_OR)
+                *acc |= *bus;
+            else if(control == OP_XOR)
+                *acc ^= *bus;
+            else
+                *acc = ~*acc;
+            affected = ZF_MASK;
+            set = *acc == 0 ? ZF_MASK : 0;
+            break;
+        case OP_SHL:
+            affected = CF_MASK;
+            set = *acc & 0x8000 ? CF_MASK : 0;
+            *acc <<= 1;
+            break;
+        case OP_SHR:
+            affected = CF_MASK;
+            set = *acc & 0x01 ? CF_MASK : 0;
+            *acc >>= 1;
+            break;
+        case OP_WACC:
+            *acc = (*acc & 0xFF00) | *bus;
+            break;
+        case OP_RACC:
+            *bus = *acc & 0xFF;
+            break;
+        default: // an invalid control signal does nothing
+            break;
+    }
+    *flags = (*flags & ~affected) | set;
+}
+
+/*===============================================
+*   FUNCTION    :   coreBranchTaken
+*   DESCRIPTION :   Condition of BRLT (SF = 1), BRGT (SF = 0), BRNE (ZF = 0)
+*                   and BRE (ZF = 1), tested after the compare subtracted MBR
+*                   from ACC.
+*   ARGUMENTS   :   UNSIGNED INT inst_code, UNSIGNED INT flags
+*   RETURNS     :   BOOL
+ *==============================================*/
+static inline bool coreBranchTaken(unsigned int inst_code, unsigned int flags)
+{
+    if(inst_code == OP_BRLT)
+        return (flags & SF_MASK) != 0;
+    if(inst_code == OP_BRGT)
+        return (flags & SF_MASK) == 0;
+    if(inst_code == OP_BRNE)
+        return (flags & ZF_MASK) == 0;
+    return (flags & ZF_MASK) != 0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+ /*======================================================================================================
+* FILE        : Memory.h
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : The main memory backends: the flat array of LE2 - LE5 and the chips of LE6, eight
+*               chips of 32 rows by 32 columns per group, chip n holding bit n - 1 of every cell.
+*               MainMemory() of LE6 and of CORE/Core.c and the MemBench microbenchmark compile
+*               these same functions, so what MemBench times is what the simulators run. The
+*               models around an access (caches, row buffer, heatmap, banks) stay in LE6.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+======================================================================================================*/
+#ifndef MEMORY_H
+#define MEMORY_H
+
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#include "Core.h"
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define CHIP_ROWS 32
+#define CHIP_COLS 32
+#define CHIP_COUNT 8            // a chip per bit of a cell
+
+/*===============================================
+*   FUNCTION    :   setBit
+*   DESCRIPTION :   This function sets the bit at the given position.
+*   ARGUMENTS   :   long*, int, int
+*   RETURNS     :   VOID
+ *==============================================*/
+static inline void setBit(long *num, int pos, int value)
+{
+    if(value == 0)
+        *num &= ~(1u << pos); // Clear the bit at the given position
+    else
+        *num |= (1u << pos);  // Set the bit at the given position
+}
+
+/*===============================================
+*   FUNCTION    :   getBit
+*   DESCRIPTION :   This function gets the bit at the given position.
+*   ARGUMENTS   :   long, int
+*   RETURNS     :   INT
+ *==============================================*/
+static inline int getBit(long num, int pos)
+{
+    return (num >> pos) & 1;
+}
+
+/*===============================================
+*   FUNCTION    :   chipRead
+*   DESCRIPTION :   Reads the cell at an address from a group of chips: col =
+*                   bits 4 - 0, row = bits 9 - 5, a bit from every chip. The
+*                   caller picks the group (cs = address >> 10).
+*   ARGUMENTS   :   long *const chips[8] (chip 1 - 8), UNSIGNED INT address
+*   RETURNS     :   UNSIGNED CHAR
+ *==============================================*/
+static inline unsigned char chipRead(long *const chips[CHIP_COUNT], unsigned int address)
+{
+    int col = address & 0x001F, row = (address >> 5) & 0x001F, i;
+    unsigned char data = 0;
+
+    for(i = 0; i < CHIP_COUNT; i++)
+        data |= getBit(chips[i][row], col) << i;
+    return data;
+}
+
+/*===============================================
+*   FUNCTION    :   chipWrite
+*   DESCRIPTION :   Writes a cell at an address to a group of chips, bit n of
+*                   the data to chip n + 1.
+*   ARGUMENTS   :   long *const chips[8], UNSIGNED INT address, UNSIGNED CHAR data
+*   RETURNS     :   VOID
+ *==============================================*/
+static inline void chipWrite(long *const chips[CHIP_COUNT], unsigned int address, unsigned char data)
+{
+    int col = address & 0x001F, row = (address >> 5) & 0x001F, i;
+
+    for(i = 0; i < CHIP_COUNT; i++)
+        setBit(&chips[i][row], col, (data >> i) & 1);
+}
+
+/*===============================================
+*   FUNCTION    :   flatRead / flatWrite
+*   DESCRIPTION :   The flat memory of LE2 - LE5, an address past 0x7FF wraps.
+*   ARGUMENTS   :   memory, UNSIGNED INT address / and UNSIGNED CHAR data
+*   RETURNS     :   UNSIGNED CHAR / VOID
+ *==============================================*/
+static inline unsigned char flatRead(const unsigned char memory[MEMORY_SIZE], unsigned int address)
+{
+    return memory[address & ADDRESS_MASK];
+}
+
+static inline void flatWrite(unsigned char memory[MEMORY_SIZE], unsigned int address, unsigned char data)
+{
+    memory[address & ADDRESS_MASK] = data;
+}
+
+#endif
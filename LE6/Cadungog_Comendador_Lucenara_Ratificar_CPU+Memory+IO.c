@@ -8,34 +8,74 @@
 * COPYRIGHT   : 22 April, 2024
 * REVISION HISTORY:
 *   5 May, 2024: V1.0 - File Created
+*   19 October, 2026: V1.1 - Loads program images produced by TOOLS/Assembler.c
+*   19 October, 2026: V1.2 - FLAGS bits follow TRACS, compare-branches subtract MBR from ACC,
+*                            WM writes MBR, RACC loads ACC to MBR, MUL stores the product
+*   19 October, 2026: V1.3 - Instruction and cycle budgets, wall-clock watchdog and quiet (-q) mode
+*   19 October, 2026: V1.4 - Idle loops are fast-forwarded to the end of the budget
+*   19 October, 2026: V1.5 - SevenSegment renders into a framebuffer, redraws on change, FPS limit
+*   19 October, 2026: V1.6 - InputSim streams a file, FIFO or stdin into 0x010 - 0x01F, RIO reads IOMemory
+*   19 October, 2026: V1.7 - IOMemory dispatches to devices registered on address ranges
+*   19 October, 2026: V1.8 - Interrupt controller at 0x020 - 0x023, RETI (0x08) returns from a handler
+*   19 October, 2026: V1.9 - DMA engine at 0x024 - 0x029, steals the bus between instructions
+*   19 October, 2026: V1.10 - Timer at 0x02A - 0x030 on an event queue, idle loops skip to the next event
+*   19 October, 2026: V1.11 - Event kernel on a min-heap, DMA and input polling run as events
+*   19 October, 2026: V1.12 - Input record (-R) and replay (-P) in a binary log
+*   19 October, 2026: V1.13 - Instruction (-I) and data (-D) cache models with miss penalties
+*   19 October, 2026: V1.14 - Chip access heatmap (-H) as CSV and PPM, row activation counts
+*   19 October, 2026: V1.15 - Row buffer latency model of the chips (-M)
+*   19 October, 2026: V1.16 - Bank switching of chip group B, bank select at IO 0x031
+*   19 October, 2026: V1.17 - Lockstep co-simulation (-L) of the chips against LE5's flat memory
+*   19 October, 2026: V1.18 - Idle loops polling the timer count, or with -H, -M, -I or -D, are not skipped
+*   19 October, 2026: V1.19 - A FIFO input waits for its writer, stdin gets its blocking mode back at exit
+*   19 October, 2026: V1.20 - The watchdog measures a monotonic wall clock instead of whole time() seconds
+*   19 October, 2026: V1.21 - The FPS limit of the display measures the same wall clock instead of clock()
+*   19 October, 2026: V1.22 - Free-running counter at 0x032 - 0x033, byte pipe (UART) at 0x034 - 0x035
+*   19 October, 2026: V1.23 - Instruction codes, cycles, ALU, Booth steps and branch conditions from CORE/Core.h
+*   19 October, 2026: V1.24 - MainMemory() reads and writes the chips through CORE/Memory.h, no malloc() per write
 ======================================================================================================*/
 /*===============================================
  *   HEADER FILES
  *==============================================*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <limits.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#else
+#include <windows.h>
+#endif
+#include "../CORE/Core.h" // instruction codes, FLAGS bits, cycles, ALU and Booth steps
+#include "../CORE/Memory.h" // chip and flat memory backends
 
 /*===============================================
  *   DEFINITIONS AND CONSTANTS
  *==============================================*/
 // ALU Constants
-#define addition 0x1E
-#define subtraction 0x1D
-#define multiplication 0x1B
-#define AND 0x1A
-#define OR 0x19
-#define NOT 0x18
-#define XOR 0x17
-#define shift_left 0x16
-#define shift_right 0x15
-#define WACC 0x09
-#define RACC 0x0B
+#define addition OP_ADD
+#define subtraction OP_SUB
+#define multiplication OP_MUL
+#define AND OP_AND
+#define OR OP_OR
+#define NOT OP_NOT
+#define XOR OP_XOR
+#define shift_left OP_SHL
+#define shift_right OP_SHR
+#define WACC OP_WACC
+#define RACC OP_RACC
 
 unsigned int FLAGS = 0x00; // Flags
-unsigned char SF, CF, ZF, OF; // Flags
+unsigned int ACC = 0x0000; // 16-bit accumulator, only the ALU changes it
 unsigned char CONTROL = 0;
 
 // Control Unit Constants
@@ -49,53 +89,477 @@ bool OE = 0;
 // Memory Constants
 long A1[32], A2[32], A3[32], A4[32], A5[32], A6[32], A7[32], A8[32]; // chip group A
 long B1[32], B2[32], B3[32], B4[32], B5[32], B6[32], B7[32], B8[32]; // chip group B
+long *const chipsA[8] = {A1, A2, A3, A4, A5, A6, A7, A8};
+
+// Bank switching, 0x400 - 0x7FF (chip group B) shows one of BANK_COUNT banks of chips. Bank 0
+// is B1 - B8, the others are allocated when they are first written (reading a bank that was
+// never written gives zeros), so a program only costs the host memory of the banks it uses.
+#define BANK_SELECT 0x031
+#define BANK_COUNT 256
+typedef long BankChips[8][32]; // B1 - B8 of a bank
+BankChips *banks[BANK_COUNT];  // NULL until written, banks[0] is unused
+long *const bankZero[8] = {B1, B2, B3, B4, B5, B6, B7, B8};
+long *bankPlanes[8] = {B1, B2, B3, B4, B5, B6, B7, B8}; // chips of the selected bank, NULLs if not allocated
+unsigned char bankSelected = 0;
+unsigned int bankAllocated = 1; // banks holding data, bank 0 included
+
+// Lockstep co-simulation (-L), LE5's flat memory (dataMemory[], BUS = dataMemory[ADDR]) runs
+// beside the chips: every write goes to both and every read of the chips is compared with it.
+// LE5 has no banks, banks other than 0 are not compared.
+#define COSIM_HISTORY 8 // accesses shown before a divergence
+typedef struct
+{
+    unsigned long long cycle;
+    unsigned int address;
+    unsigned char value;
+    bool write;
+} MemoryAccess;
+bool cosimEnabled = false, cosimDiverged = false;
+unsigned long long cosimReads = 0;
+unsigned int cosimAddress = 0;
+unsigned char cosimChips = 0, cosimFlat = 0; // the two values of the diverging read
+MemoryAccess cosimHistory[COSIM_HISTORY];
+unsigned int cosimCount = 0;
+
+// Cache models on instruction fetch (-I) and RM/WM (-D). Only tags are kept, the data stays in
+// the chips (write-through, write-allocate), so a cache changes the cycle count and nothing else.
+// Sizes are powers of two: set = (address >> lineShift) & setMask, tag = address >> tagShift.
+#define CACHE_LRU 0
+#define CACHE_FIFO 1
+#define CACHE_RANDOM 2
+#define CACHE_MAX_LINES 2048 // one byte lines over the whole memory
+#define CACHE_PENALTY 4      // default miss penalty in cycles
+typedef struct
+{
+    const char *name;
+    bool enabled;
+    unsigned int lineShift, setMask, tagShift, ways, policy, penalty;
+    unsigned int tag[CACHE_MAX_LINES];             // set * ways + way
+    bool valid[CACHE_MAX_LINES];
+    unsigned long long stamp[CACHE_MAX_LINES];     // last use (LRU) or fill (FIFO)
+    unsigned long long clock, hits, misses, evictions, penaltyCycles;
+} Cache;
+Cache instructionCache = {.name = "I-cache"}, dataCache = {.name = "D-cache"};
+
+// Chip access statistics (-H), counted by MainMemory() while the program runs. The eight chips
+// of a group are bit planes of the same cell, every access reaches all of them at (row, col),
+// so the counts per group are the counts of each of its chips. A row activation is an access
+// to another row than the group's previous one.
+#define CHIP_GROUPS 2 // of CHIP_ROWS x CHIP_COLS cells (CORE/Memory.h)
+bool chipStatsEnabled = false;
+const char *heatmapPath = NULL; // prefix of the .csv and .ppm written at the end of the run
+unsigned long long chipReads[CHIP_GROUPS][CHIP_ROWS][CHIP_COLS], chipWrites[CHIP_GROUPS][CHIP_ROWS][CHIP_COLS];
+unsigned long long rowActivations[CHIP_GROUPS];
+int lastRow[CHIP_GROUPS] = {-1, -1};
+
+// Row buffer latency model (-M), extra cycles of a chip access on top of the fixed cycle model.
+// Each group keeps its last row open: the same row is a hit, another row a miss (precharge and
+// activate), and an access to the other group than the previous one pays the chip select switch.
+// Accesses through a cache model (-I, -D) pay the latency on a miss instead, as its penalty.
+#define DRAM_ROW_HIT 0
+#define DRAM_ROW_MISS 3
+#define DRAM_CS_SWITCH 1
+bool dramEnabled = false, dramBypass = true; // dramBypass: no latency (off, loading, or served by a cache)
+unsigned int dramRowHit = DRAM_ROW_HIT, dramRowMiss = DRAM_ROW_MISS, dramSwitch = DRAM_CS_SWITCH;
+int dramOpenRow[CHIP_GROUPS] = {-1, -1}, dramLastGroup = -1;
+unsigned long long dramHits = 0, dramMisses = 0, dramSwitches = 0, dramCycles = 0;
+unsigned int cacheSeed = 0x2545F491; // xorshift state of the random policy
+// miss penalty hook, cycles a miss of the line holding address costs (default: cache->penalty)
+unsigned int (*cacheMissPenalty)(Cache *cache, unsigned int address) = NULL;
 
 // IO Constants
 unsigned char iOData[32];
 
+// IO devices, each owns a range of the 11-bit IO address space
+#define IO_SPACE 2048
+#define MAX_IO_DEVICES 16
+typedef struct
+{
+    const char *name;
+    unsigned int base, size;
+    unsigned char (*read)(unsigned int offset);             // NULL: write-only, BUS is left as is
+    void (*write)(unsigned int offset, unsigned char data); // NULL: read-only
+} IODevice;
+IODevice ioDevices[MAX_IO_DEVICES];
+int ioDeviceCount = 0;
+IODevice *ioMap[IO_SPACE]; // device of every IO address, NULL if unmapped
+
+// Interrupt controller, checked by CU() between instructions
+#define IRQ_PENDING 0x020   // pending lines, writing 1s acknowledges edge lines
+#define IRQ_MASK 0x021      // enabled lines
+#define IRQ_VECTOR_LO 0x022 // handler address, bits 7 - 0
+#define IRQ_VECTOR_HI 0x023 // handler address, bits 10 - 8
+#define IRQ_INPUT 0x01      // level: the input stream has a byte
+#define IRQ_DMA 0x02        // edge: a DMA transfer completed
+#define IRQ_TIMER 0x04      // edge: the timer expired
+#define INPUT_POLL_CYCLES 256 // cycles between two reads of an empty input stream
+#define INTERRUPT_CYCLES 2  // saving the registers and loading the vector
+unsigned char irqPending = 0, irqMask = 0;
+unsigned int irqVector = 0x000;
+bool inInterrupt = false; // no nesting, RETI ends the handler
+unsigned int irqPC, irqACC, irqFLAGS, irqMBR, irqIOBR; // registers saved on entry, restored by RETI
+unsigned long long interruptCount = 0;
+
+// DMA engine, moves one byte between IO and main memory between two instructions
+#define DMA_IO_LO 0x024     // IO address, bits 7 - 0
+#define DMA_IO_HI 0x025     // IO address, bits 10 - 8
+#define DMA_MEM_LO 0x026    // main memory address, bits 7 - 0
+#define DMA_MEM_HI 0x027    // main memory address, bits 10 - 8
+#define DMA_COUNT 0x028     // bytes left, writing 0 means 256
+#define DMA_CONTROL 0x029   // write: start and mode, read: mode and busy
+#define DMA_START 0x01
+#define DMA_TO_IO 0x02      // main memory -> IO, otherwise IO -> main memory
+#define DMA_FIXED_IO 0x04   // keep the IO address (a port like INPUT_DATA)
+#define DMA_IRQ 0x08        // raise IRQ_DMA when done
+#define DMA_BUSY 0x80
+#define DMA_BYTE_CYCLES 2   // one IO bus cycle and one memory bus cycle
+#define DMA_GAP_CYCLES 1    // the bus request after a byte waits for the next instruction boundary
+unsigned int dmaIO = 0, dmaMem = 0, dmaCount = 0;
+unsigned char dmaControl = 0;
+unsigned long long dmaCycles = 0; // bus cycles stolen from the CU
+
+// Event kernel, devices schedule work at a simulated cycle instead of checking every cycle.
+// A binary min-heap on (cycle, sequence), events due at the same cycle run in the order
+// they were scheduled. CU() runs the due events at instruction boundaries.
+#define MAX_EVENTS 64
+#define NO_EVENT ULLONG_MAX
+typedef struct
+{
+    unsigned long long cycle, sequence;
+    void (*handler)(void);
+} Event;
+Event events[MAX_EVENTS];
+int eventCount = 0;
+unsigned long long eventSequence = 0, eventsRun = 0;
+unsigned long long nextEventCycle = NO_EVENT; // events[0].cycle, read by CU() every instruction
+
+// Timer, counts down every (prescaler + 1) cycles and expires at zero
+#define TIMER_RELOAD_LO 0x02A  // ticks per period, bits 7 - 0 (0 with HI = 65536)
+#define TIMER_RELOAD_HI 0x02B  // ticks per period, bits 15 - 8
+#define TIMER_PRESCALER 0x02C  // cycles per tick minus one
+#define TIMER_CONTROL 0x02D
+#define TIMER_STATUS 0x02E     // bit 0 expired, writing 1 clears it
+#define TIMER_COUNT_LO 0x02F   // ticks left in the period (read only)
+#define TIMER_COUNT_HI 0x030
+#define TIMER_ENABLE 0x01
+#define TIMER_PERIODIC 0x02    // reload and continue, otherwise stop at zero
+#define TIMER_IRQ 0x04         // raise IRQ_TIMER on expiry
+#define TIMER_EXPIRED 0x01
+unsigned int timerReload = 0, timerPrescaler = 0;
+unsigned char timerControl = 0, timerStatus = 0;
+unsigned long long timerDue = 0; // cycle of the next expiry while enabled
+
+// Free-running counter of the cycles since it was last cleared. Reading COUNTER_LO latches the
+// upper byte, so LO then HI read one 16-bit count.
+#define COUNTER_LO 0x032       // bits 7 - 0, writing either register clears the count
+#define COUNTER_HI 0x033       // bits 15 - 8 as latched by the last read of COUNTER_LO
+unsigned long long counterStart = 0; // cycleCount when the count was 0
+unsigned char counterLatch = 0;
+
+// Byte pipe (UART-like, TX looped back to RX). A byte written to UART_DATA is shifted out in
+// UART_BYTE_CYCLES and can then be read back from UART_DATA, in order. The queue holds the bytes
+// in flight and the received ones; a write to a full queue is dropped.
+#define UART_DATA 0x034        // write: send a byte, read: the oldest received byte (0 if none)
+#define UART_STATUS 0x035      // bit 0 a byte was received, bit 1 the queue is full (read only)
+#define UART_RECEIVED 0x01
+#define UART_FULL 0x02
+#define UART_QUEUE 16          // a power of two
+#define UART_BYTE_CYCLES 10    // start bit, 8 data bits and a stop bit, a cycle each
+unsigned char uartQueue[UART_QUEUE];
+unsigned int uartHead = 0, uartArrived = 0, uartTail = 0; // free running: head - arrived received, arrived - tail in flight
+unsigned long long uartDue = 0; // cycle the byte shifting out is received
+
+// Seven segment display, drawn from a framebuffer only when the digit changes
+#define SEGMENT_ROWS 7
+#define SEGMENT_COLS 8 // widest glyph row plus the newline
+char segmentFrame[SEGMENT_ROWS * SEGMENT_COLS + 1];
+int segmentShown = -1;      // digit on the terminal, -1 before the first frame
+int segmentPending = -1;    // digit rendered but held back by the FPS limit
+bool segmentEnabled = true; // -n turns the display off for headless runs
+double segmentFPS = 0;      // redraws per second, 0 = every change
+double segmentLastFlush = 0; // wallClock() of the last redraw
+
+// Input stream device (InputSim), bytes from a file, FIFO or stdin
+#define INPUT_DATA 0x010   // next byte of the stream, reading it consumes the byte
+#define INPUT_STATUS 0x011 // bit 0 a byte is available, bit 1 end of input
+#define INPUT_COUNT 0x012  // bytes waiting in the ring buffer (at most 0xFF)
+#define INPUT_RING 4096    // ring buffer size, a power of two
+#define INPUT_AVAILABLE 0x01
+#define INPUT_END 0x02
+unsigned char inputRing[INPUT_RING];
+unsigned int inputHead = 0, inputTail = 0; // free running, tail - head bytes are buffered
+bool inputOpen = false, inputEOF = false;
+#ifdef _WIN32
+FILE *inputFile = NULL; // no non-blocking pipes in the C library, filled with fread()
+#else
+int inputFd = -1;       // O_NONBLOCK, a slow FIFO or terminal never stalls the CU
+int inputFlags = -1;    // file status flags of inputFd before O_NONBLOCK, put back by InputClose()
+bool inputWaiting = false; // a FIFO without a writer yet, read() returns 0 until one connects
+#endif
+
+// Input log, every chunk InputFill() got from the stream with the cycle it arrived. Replaying it
+// delivers the same bytes at the same cycles whatever the live source did. Format: "LE6I" and a
+// version byte, then per chunk the cycles since the previous chunk and the chunk length (LEB128
+// varints) followed by the bytes. Length 0 is the end of input, the end of the log is not (the
+// stream was still open when the recorded run stopped).
+#define LOG_MAGIC "LE6I"
+#define LOG_VERSION 1
+FILE *recordFile = NULL, *replayFile = NULL;
+unsigned long long logCycle = 0;    // cycle of the last chunk written or read
+unsigned long long replayCycle = 0; // cycle of the pending chunk
+unsigned long long replayLeft = 0;  // bytes of the pending chunk not delivered yet
+bool replayPending = false;         // a chunk header was read
+
+// Run limits (0 = no limit) and the termination status returned by CU()
+#define RUN_ERROR 0
+#define RUN_EOP 1
+#define RUN_INSTRUCTION_BUDGET 2
+#define RUN_CYCLE_BUDGET 3
+#define RUN_WATCHDOG 4
+#define RUN_IDLE 5 // idle loop and no budget to fast-forward to
+#define WATCHDOG_INTERVAL 4096 // instructions between two wall-clock checks
+unsigned long long instructionBudget = 0, cycleBudget = 0;
+double watchdogSeconds = 0; // wall clock, wallClock() seconds
+unsigned long long instructionCount = 0, cycleCount = 0;
+unsigned long long writeCount = 0; // WM, WIO, DMA, device events and timer count reads, anything an idle loop must not see
+unsigned long long idleCycles = 0; // cycles skipped by fast-forwarding idle loops
+
+// Trace output of the CU and ALU, -q turns it off together with the pause
+bool quiet = false;
+#define trace(...) do { if (!quiet) printf(__VA_ARGS__); } while (0)
+
 /*===============================================
  *   FUNCTION PROTOTYPES
  *==============================================*/
 // ALU prototypes
 int ALU(void);
-unsigned char twosComp(unsigned char operand);
 void printBin(int data, unsigned char data_width);
-void setFlags(unsigned int ACC);
-void boothsAlogrithm(unsigned char Q, unsigned char M);
+unsigned int boothsAlogrithm(unsigned char M, unsigned char Q);
 void displayStep(unsigned char A, unsigned char Q, unsigned char Q_N1, unsigned char M, int n);
 
 
 // CU prototypes
 int CU();
+unsigned int instructionCycles(unsigned int inst_code);
+unsigned long long idlePeriods(unsigned long long period, unsigned long long cycles);
+double wallClock(void);
 void initMemory();
+int loadImage(const char *path);
 void displayData(unsigned int PC, unsigned int MAR, unsigned int IOAR, unsigned int IOBR, unsigned int IR, unsigned int inst_code, unsigned int CONTROL, unsigned int BUS, unsigned int ADDR, unsigned int operand); // New Changes to displayData call
 void MainMemory(void);
+int cacheConfigure(Cache *cache, const char *spec);
+bool cacheAccess(Cache *cache, unsigned int address);
+void cacheReport(Cache *cache);
+int heatmapWrite(const char *prefix);
+unsigned int dramLatency(unsigned int address);
+unsigned int dramCachePenalty(Cache *cache, unsigned int address);
 void IOMemory(void);
+int IORegister(const char *name, unsigned int base, unsigned int size,
+               unsigned char (*read)(unsigned int offset), void (*write)(unsigned int offset, unsigned char data));
+void IOInit(void);
+unsigned char interruptLines(void);
+void inputLine(void);
+void inputPoll(void);
+unsigned char interruptRead(unsigned int offset);
+void interruptWrite(unsigned int offset, unsigned char data);
+unsigned char DMARead(unsigned int offset);
+void DMAWrite(unsigned int offset, unsigned char data);
+void DMATransfer(void);
+void scheduleEvent(unsigned long long cycle, void (*handler)(void));
+void cancelEvent(void (*handler)(void));
+void runEvents(void);
+bool eventBefore(int a, int b);
+void eventSwap(int a, int b);
+void eventUp(int i);
+void eventDown(int i);
+unsigned char timerRead(unsigned int offset);
+void timerWrite(unsigned int offset, unsigned char data);
+void timerExpire(void);
+unsigned long long timerPeriod(void);
+unsigned char counterRead(unsigned int offset);
+void counterWrite(unsigned int offset, unsigned char data);
+unsigned char uartRead(unsigned int offset);
+void uartWrite(unsigned int offset, unsigned char data);
+void uartShift(void);
+unsigned char bankRead(unsigned int offset);
+void bankWrite(unsigned int offset, unsigned char data);
+bool bankAllocate(void);
+void cosimAccess(void);
+void cosimReport(unsigned int instAddress, unsigned int IR);
 
 // Memory prototypes
 void displayMemory(void);
-int getBit(long num, int pos);
-void setBit(long* num, int pos, int value);
-int* charToBinary(unsigned char c);
 
 // IO prototypes
 void InputSim(void);
+int InputOpen(const char *path);
+void InputClose(void);
+void InputFill(void);
+int RecordOpen(const char *path);
+int ReplayOpen(const char *path);
+void RecordChunk(const unsigned char *data, unsigned long long length);
+void ReplayFill(unsigned char *data, unsigned int space);
+void writeVarint(FILE *file, unsigned long long value);
+bool readVarint(FILE *file, unsigned long long *value);
 void SevenSegment();
+void SevenSegmentWrite(unsigned int offset, unsigned char data);
+void latchWrite(unsigned int offset, unsigned char data);
+unsigned char latchRead(unsigned int offset);
+unsigned char InputSimRead(unsigned int offset);
+void SevenSegmentFlush(bool force);
 
 /*===============================================
 *   FUNCTION    :   MAIN
-*   DESCRIPTION :   This function is the entry point of the program.
-*   ARGUMENTS   :   VOID
-*   RETURNS     :   VOID
+*   DESCRIPTION :   This function is the entry point of the program. An optional
+*                   image file (see TOOLS/Assembler.c) replaces the built-in program.
+*                   -i and -c limit the executed instructions and cycles, -t stops
+*                   the run after the given wall-clock seconds, -q runs without
+*                   trace output and pauses. -f limits the display redraws per
+*                   second and -n turns the display off. -r streams a file, FIFO
+*                   or stdin (-) into the input device, -R records what it
+*                   delivered and -P replays such a log instead of a stream.
+*                   -I and -D put cache models on fetch and on RM/WM, -H
+*                   writes the accesses per chip row and column to files, -M
+*                   charges row buffer hits, misses and chip group switches,
+*                   -L compares the chips with a flat memory on every read.
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 EOP reached, 1 error, 2 budget exhausted, 3 watchdog, 4 idle loop)
  *==============================================*/
-int main()
+int main(int argc, char *argv[])
 {
-    initMemory();
-    if (CU()==1)
+    const char *image = NULL, *input = NULL;
+    int i, status;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-q") == 0)
+            quiet = true;
+        else if (strcmp(argv[i], "-n") == 0)
+            segmentEnabled = false;
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            if (input != NULL || InputOpen(argv[++i]) != 1)
+                return 1;
+            input = argv[i];
+        }
+        else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc)
+        {
+            if (recordFile != NULL || RecordOpen(argv[++i]) != 1)
+                return 1;
+        }
+        else if ((strcmp(argv[i], "-I") == 0 || strcmp(argv[i], "-D") == 0) && i + 1 < argc)
+        {
+            if (cacheConfigure(argv[i][1] == 'I' ? &instructionCache : &dataCache, argv[i + 1]) != 1)
+                return 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%u,%u,%u", &dramRowHit, &dramRowMiss, &dramSwitch) != 3)
+            {
+                printf("Error: -M needs hit,miss,switch cycles, got %s\n", argv[i]);
+                return 1;
+            }
+            dramEnabled = true;
+            cacheMissPenalty = dramCachePenalty;
+        }
+        else if (strcmp(argv[i], "-L") == 0)
+            cosimEnabled = true;
+        else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc)
+            heatmapPath = argv[++i];
+        else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc)
+        {
+            if (input != NULL || ReplayOpen(argv[++i]) != 1)
+                return 1;
+            input = argv[i];
+        }
+        else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "-t") == 0
+                  || strcmp(argv[i], "-f") == 0) && i + 1 < argc)
+        {
+            if (argv[i][1] == 'i')
+                instructionBudget = strtoull(argv[i + 1], NULL, 0);
+            else if (argv[i][1] == 'c')
+                cycleBudget = strtoull(argv[i + 1], NULL, 0);
+            else if (argv[i][1] == 'f')
+                segmentFPS = strtod(argv[i + 1], NULL);
+            else
+                watchdogSeconds = strtod(argv[i + 1], NULL);
+            i++;
+        }
+        else if (argv[i][0] == '-' || image != NULL)
+        {
+            printf("Usage: %s [-q] [-n] [-f fps] [-r input | -P log] [-R log] [-I cache] [-D cache] [-H heatmap] [-M hit,miss,switch] [-L] [-i instructions] [-c cycles] [-t seconds] [image.bin]\n", argv[0]);
+            return 1;
+        }
+        else
+            image = argv[i];
+    }
+    if (input != NULL && strcmp(input, "-") == 0 && replayFile == NULL && !quiet)
+    {
+        printf("Error: input from stdin needs -q (stdin is used for the pause)\n");
+        return 1;
+    }
+    if (recordFile != NULL && (input == NULL || replayFile != NULL))
+    {
+        printf("Error: -R records the stream given with -r\n");
+        return 1;
+    }
+
+    IOInit();
+    if (image != NULL)
+    {
+        if (loadImage(image) != 1)
+            return 1;
+    }
+    else
+        initMemory();
+
+    chipStatsEnabled = heatmapPath != NULL; // the program's accesses, not loading it
+    dramBypass = !dramEnabled;
+    status = CU();
+    dramBypass = true;
+    SevenSegmentFlush(true); // last digit held back by the FPS limit
+    if (recordFile != NULL && fclose(recordFile) != 0)
+        printf("\nError: the input log could not be written");
+    if (status == RUN_EOP)
         printf("\nProgram ran successfully!");
+    else if (status == RUN_INSTRUCTION_BUDGET)
+        printf("\nThe program was stopped after its budget of %llu instructions.", instructionBudget);
+    else if (status == RUN_CYCLE_BUDGET)
+        printf("\nThe program was stopped after its budget of %llu cycles.", cycleBudget);
+    else if (status == RUN_WATCHDOG)
+        printf("\nThe program was stopped by the watchdog after %g seconds.", watchdogSeconds);
+    else if (status == RUN_IDLE)
+        printf("\nThe program was stopped in a loop that never changes its state.");
     else
         printf("\nThe program was terminated after encountering an error.");
-    return 0;
+    printf("\n%llu instructions, %llu cycles", instructionCount, cycleCount);
+    if (idleCycles > 0)
+        printf(" (%llu cycles fast-forwarded in idle loops)", idleCycles);
+    if (interruptCount > 0)
+        printf(", %llu interrupts", interruptCount);
+    if (dmaCycles > 0)
+        printf(", %llu cycles of DMA", dmaCycles);
+    if (bankAllocated > 1)
+        printf(", %u memory banks", bankAllocated);
+    printf("\n");
+    cacheReport(&instructionCache);
+    cacheReport(&dataCache);
+    if (dramEnabled)
+        printf("Row buffer: %llu hits, %llu misses, %llu chip group switches, %llu cycles\n",
+               dramHits, dramMisses, dramSwitches, dramCycles);
+    if (cosimEnabled && !cosimDiverged)
+        printf("Co-simulation: %llu reads of the chips matched the flat memory\n", cosimReads);
+    if (heatmapPath != NULL && heatmapWrite(heatmapPath) != 1)
+        return 1;
+
+    if (status == RUN_EOP)
+        return 0;
+    if (status == RUN_INSTRUCTION_BUDGET || status == RUN_CYCLE_BUDGET)
+        return 2;
+    if (status == RUN_WATCHDOG)
+        return 3;
+    return status == RUN_IDLE ? 4 : 1;
 }
 
 /*===============================================
@@ -107,26 +571,76 @@ int main()
 int CU()
 {
     unsigned int PC=0, IR=0, MAR=0, MBR=0, IOAR=0, IOBR=0, inst_code=0, operand=0;
-    int result = 0, i;
+    int result = RUN_ERROR, i;
     bool isEOP = false; // End of Program
     bool Fetch, IO, Memory, Increment;
+    double start = wallClock();
+    // state at the last taken backward branch, to recognize a loop that goes round without changing anything
+    unsigned int instAddress = 0, loopPC = 0xFFFF, loopState[9];
+    unsigned long long loopInstructions = 0, loopCycles = 0, loopWrites = 0, periods;
     // Instruction Code 4 | 3 | 2 | 1 | 0
     // Instruction code is 5 bits wide...
     PC = 0x000;
     MainMemory();
     while(isEOP == false)
     {
-        // Debugging purposes, just loading getchar() to pause the program
-        printf("\n\nPress Enter to continue...\n");
-        // Printing the instruciton code in binary
-        // printf("Instruction Code: 0x%02x\n", inst_code);
-        // printf("Instruction Code: 0x%02x\nBinary:", inst_code);
-        // printBin(inst_code, 5);
-        // printf("\n\n");
-        getchar();
+        /* run limits, checked before the next fetch */
+        if(cosimDiverged)
+        {
+            cosimReport(instAddress, IR);
+            result = RUN_ERROR;
+            break;
+        }
+        if(instructionBudget && instructionCount >= instructionBudget)
+        {
+            result = RUN_INSTRUCTION_BUDGET;
+            break;
+        }
+        if(cycleBudget && cycleCount >= cycleBudget)
+        {
+            result = RUN_CYCLE_BUDGET;
+            break;
+        }
+        if(watchdogSeconds > 0 && instructionCount % WATCHDOG_INTERVAL == 0
+           && wallClock() - start >= watchdogSeconds)
+        {
+            result = RUN_WATCHDOG;
+            break;
+        }
+
+        /* device events that are due */
+        if(cycleCount >= nextEventCycle)
+            runEvents();
+
+        /* interrupt check, the handler gets the registers back with RETI */
+        if(!inInterrupt && interruptLines())
+        {
+            irqPC = PC;
+            irqACC = ACC;
+            irqFLAGS = FLAGS;
+            irqMBR = MBR;
+            irqIOBR = IOBR;
+            inInterrupt = true;
+            PC = irqVector;
+            cycleCount += INTERRUPT_CYCLES;
+            interruptCount++;
+            trace("\nInterrupt 0x%02x, PC <- 0x%03x (return to 0x%03x)\n", irqPending & irqMask, PC, irqPC);
+        }
+
+        if(!quiet)
+        {
+            // Debugging purposes, just loading getchar() to pause the program
+            printf("\n\nPress Enter to continue...\n");
+            // Printing the instruciton code in binary
+            // printf("Instruction Code: 0x%02x\n", inst_code);
+            // printf("Instruction Code: 0x%02x\nBinary:", inst_code);
+            // printBin(inst_code, 5);
+            // printf("\n\n");
+            getchar();
+        }
 
-        printf("\n**************************\n");
-        printf("PC \t\t\t\t: 0x%03x \n", PC);
+        trace("\n**************************\n");
+        trace("PC \t\t\t\t: 0x%03x \n", PC);
 
 
         /* setting external control signals */
@@ -141,7 +655,14 @@ int CU()
         Memory = 0;
 
         /* fetching the upper byte */
+        instAddress = PC;
         ADDR = PC;
+        if(instructionCache.enabled)
+        {
+            cacheAccess(&instructionCache, PC);
+            cacheAccess(&instructionCache, PC + 1);
+            dramBypass = true;
+        }
         MainMemory(); //fetch upper byte
 
         if(Fetch == 1)
@@ -160,15 +681,18 @@ int CU()
                             // 8 bits of IR
             PC++; // points to the next instruction
         }
+        dramBypass = !dramEnabled;
         /* Instruction Decode */
-        printf("Fetching Instructions...\n");
-        printf("IR  \t\t    : 0x%04x \n", IR);
+        trace("Fetching Instructions...\n");
+        trace("IR  \t\t    : 0x%04x \n", IR);
         //get 5 bit instruction code
         inst_code = IR>>11;
         //get 11 bit operand
         operand = IR & 0x07FF;
-        printf("Instruction Code: 0x%02x\n", inst_code);
-        printf("Operand \t\t: 0x%03x \n", operand);
+        trace("Instruction Code: 0x%02x\n", inst_code);
+        trace("Operand \t\t: 0x%03x \n", operand);
+        instructionCount++;
+        cycleCount += instructionCycles(inst_code);
 
 
         if(inst_code==0x01) // WM
@@ -184,11 +708,18 @@ int CU()
             RW = 1; // write operation
             OE = 1; // allow data movement to/from memory
             ADDR = MAR; // load MAR to Address Bus
-            MainMemory(); // write data in data bus to memory
             if(Memory)
                 BUS = MBR; // MBR owns the bus since control signal Memory is 1
-            printf("Instruction \t: WM \n");
-            printf("BUS <- MBR...\n");
+            if(dataCache.enabled)
+            {
+                cacheAccess(&dataCache, MAR);
+                dramBypass = true; // the latency is part of a miss penalty
+            }
+            MainMemory(); // write data in data bus to memory
+            dramBypass = !dramEnabled;
+            writeCount++;
+            trace("Instruction \t: WM \n");
+            trace("BUS <- MBR...\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             OE = 0; // disable data movement to/from memory
         }
@@ -205,19 +736,25 @@ int CU()
             RW = 0; // reading operation
             OE = 1; // allow data movement to/from memory
             ADDR = MAR; // load MAR to Address Bus
+            if(dataCache.enabled)
+            {
+                cacheAccess(&dataCache, MAR);
+                dramBypass = true; // the latency is part of a miss penalty
+            }
             MainMemory(); // write data in data bus to memory
+            dramBypass = !dramEnabled;
             if(Memory)
                 MBR = BUS;
-            printf("Instruction \t: RM \n");
-            printf("MBR <- BUS\n");
+            trace("Instruction \t: RM \n");
+            trace("MBR <- BUS\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             OE = 0; // disable data movement to/from memory
         }
         else if (inst_code==0x03) // Branch
         {
             PC = operand;
-            printf("Instruction \t: BR \n");
-            printf("Branching to 0x%03x to the next cycle.\n", PC);
+            trace("Instruction \t: BR \n");
+            trace("Branching to 0x%03x to the next cycle.\n", PC);
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             // Added IR, inst_code, control, bus, addr
         }
@@ -230,16 +767,17 @@ int CU()
             IO = 1;
             /* setting external control signals */
             CONTROL = inst_code; // setting the control signals
-            IOM = 0; // Main Memory access
-            RW = 1;
+            IOM = 0; // IO Memory access
+            RW = 0; // read operation
             OE = 1; // allow data movement to/from memory
             ADDR = IOAR;
+            IOMemory(); // load data from IO Memory to BUS
             if(IO)
                IOBR = BUS;
 
-            printf("Instruction \t: RIO \n");
-            printf("WRITING BUS TO IOBR...\n");
-            printf("IOBR \t\t: 0x%02x \n", IOBR);
+            trace("Instruction \t: RIO \n");
+            trace("WRITING BUS TO IOBR...\n");
+            trace("IOBR \t\t: 0x%02x \n", IOBR);
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             // Added IR, inst_code, control, bus, addr
         }
@@ -260,28 +798,43 @@ int CU()
             //    BUS = IOBR;
                 BUS = IOBR;
             IOMemory();
-            SevenSegment();
+            writeCount++;
             // iOData[ADDR] = 0x01;
-            printf("Instruction \t: WIO \n");
-            printf("Storing information into memory....\n");
+            trace("Instruction \t: WIO \n");
+            trace("Storing information into memory....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             // Added IR, inst_code, control, bus, addr
         }
+        else if(inst_code==0x08) // Return from interrupt
+        {
+            if(inInterrupt)
+            {
+                PC = irqPC;
+                ACC = irqACC;
+                FLAGS = irqFLAGS;
+                MBR = irqMBR;
+                IOBR = irqIOBR;
+                inInterrupt = false;
+            }
+            trace("Instruction \t: RETI \n");
+            trace("Returning to 0x%03x....\n", PC);
+            displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
+        }
         else if(inst_code==0x06) // write data to MBR
         {
             MBR = operand;
-            printf("Instruction \t: WB \n");
-            printf("Loading Data to MBR....\n");
-            printf("MBR \t\t\t: 0x%02x \n", MBR);
+            trace("Instruction \t: WB \n");
+            trace("Loading Data to MBR....\n");
+            trace("MBR \t\t\t: 0x%02x \n", MBR);
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             // Added IR, inst_code, control, bus, addr
         }
         else if(inst_code==0x07) // write data to IOBR
         {
             IOBR = operand;
-            printf("Instruction \t: WIB \n");
-            printf("Loading Data to IOBR....\n");
-            printf("IOBR \t\t\t: 0x%02x \n", IOBR);
+            trace("Instruction \t: WIB \n");
+            trace("Loading Data to IOBR....\n");
+            trace("IOBR \t\t\t: 0x%02x \n", IOBR);
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             // Added IR, inst_code, control, bus, addr
         }
@@ -300,9 +853,9 @@ int CU()
             if(Memory)
                 BUS = MBR;
             ALU(); // ALU
-            printf("Instruction \t: WACC \n");
-            printf("Write data on BUS to ACC....\n");
-            printf("BUS \t\t\t: 0x%02x \n", BUS);
+            trace("Instruction \t: WACC \n");
+            trace("Write data on BUS to ACC....\n");
+            trace("BUS \t\t\t: 0x%02x \n", BUS);
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if (inst_code == 0x0B) // Move ACC data to BUS
@@ -314,12 +867,12 @@ int CU()
             IO = 0;
 
 
+            ALU(); // ALU drives the BUS with ACC
             if(Memory)
                 MBR = BUS;
-            ALU(); // ALU
-            printf("Instruction \t: RACC \n");
-            printf("Move ACC data to BUS....\n");
-            printf("BUS \t\t\t: 0x%02x \n", BUS);
+            trace("Instruction \t: RACC \n");
+            trace("Move ACC data to BUS....\n");
+            trace("BUS \t\t\t: 0x%02x \n", BUS);
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code == 0x0E) // Swap data of MBR and IOBR
@@ -333,10 +886,10 @@ int CU()
             IOBR = MBR;
             MBR = tempIOBR;
 
-            printf("Instruction \t: SWAP \n");
-            printf("Swap data of MBR and IOBR....\n");
-            printf("IOBR \t\t\t: 0x%02x \n", IOBR);
-            printf("MBR \t\t\t: 0x%02x \n", MBR);
+            trace("Instruction \t: SWAP \n");
+            trace("Swap data of MBR and IOBR....\n");
+            trace("IOBR \t\t\t: 0x%02x \n", IOBR);
+            trace("MBR \t\t\t: 0x%02x \n", MBR);
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x11) //BRLT
@@ -346,58 +899,57 @@ int CU()
             /* Setting global control signals */
             CONTROL = inst_code; // setup the Control Signals
             IOM = 0; RW = 0; OE = 0; // operation neither "write" or “read”
-            CONTROL = subtraction; // setup the Control Signals
+            CONTROL = subtraction; // compare: ACC <- ACC - BUS
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            if ((FLAGS & SF) == SF)
+            if (coreBranchTaken(inst_code, FLAGS)) // branch if SF=1
                 PC = operand;
-            printf("Instruction \t: ADD \n");
-            printf("Adding ACC and BUS....\n");
+            trace("Instruction \t: BRLT \n");
+            trace("Comparing ACC and BUS....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
 
         }
         else if(inst_code==0x12) //BRGT
         {
             Fetch = 0; Memory = 1; IO = 0; // operation is bus access throug
-            CONTROL = inst_code;
+            CONTROL = subtraction; // compare: ACC <- ACC - BUS
 
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            if ((FLAGS & SF) == 0)
+            if (coreBranchTaken(inst_code, FLAGS)) // branch if SF=0
                 PC = operand;
-            printf("Instruction \t: SUBTRACT \n");
-            printf("Subtracting ACC and BUS....\n");
+            trace("Instruction \t: BRGT \n");
+            trace("Comparing ACC and BUS....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x13) //BRNE
         {
             Fetch = 0; Memory = 1; IO = 0; // operation is bus access through MBR
-            CONTROL = inst_code;
+            CONTROL = subtraction; // compare: ACC <- ACC - BUS
 
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-             if ((FLAGS & ZF) == 0)
+            if (coreBranchTaken(inst_code, FLAGS)) // branch if ZF=0
                 PC = operand;
-            printf("Instruction \t: MULTIPLY \n");
-            printf("Multiplying ACC and BUS....\n");
+            trace("Instruction \t: BRNE \n");
+            trace("Comparing ACC and BUS....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if (inst_code==0x14) //BRE
         {
             Fetch = 0; Memory = 1; IO = 0; // operation is bus access through MBR
-            // CONTROL = inst_code;
-            CONTROL = inst_code;
+            CONTROL = subtraction; // compare: ACC <- ACC - BUS
 
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            if ((FLAGS & 0x01) == 0x01)
+            if (coreBranchTaken(inst_code, FLAGS)) // branch if ZF=1
                 PC = operand;
-            printf("Instruction \t: BRE \n");
-            printf("Adding ACC and BUS....\n");
+            trace("Instruction \t: BRE \n");
+            trace("Comparing ACC and BUS....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x15) // Shift the value of ACC 1 bit to the right, CF will
@@ -411,8 +963,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: Shift Right \n");
-            printf("Shift Right....\n");
+            trace("Instruction \t: Shift Right \n");
+            trace("Shift Right....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x16) // Shift the value of ACC 1 bit to the left,
@@ -426,8 +978,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: Shift left \n");
-            printf("Shift Left....\n");
+            trace("Instruction \t: Shift left \n");
+            trace("Shift Left....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x17) // XOR the value of ACC and BUS, result stored
@@ -441,8 +993,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: XOR \n");
-            printf("XOR operation....\n");
+            trace("Instruction \t: XOR \n");
+            trace("XOR operation....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x18) // Complement the value of ACC, result stored to
@@ -456,8 +1008,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: NOT \n");
-            printf("NOT operation....\n");
+            trace("Instruction \t: NOT \n");
+            trace("NOT operation....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x19) // OR the value of ACC and BUS, result stored to
@@ -471,8 +1023,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: OR \n");
-            printf("OR operation....\n");
+            trace("Instruction \t: OR \n");
+            trace("OR operation....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x1A) // AND the value of ACC and BUS, result stored
@@ -486,8 +1038,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: AND \n");
-            printf("AND operation....\n");
+            trace("Instruction \t: AND \n");
+            trace("AND operation....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x1B) // Multiply the value of ACC to BUS, product
@@ -501,8 +1053,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: MULTIPLY \n");
-            printf("Multiplying ACC and BUS....\n");
+            trace("Instruction \t: MULTIPLY \n");
+            trace("Multiplying ACC and BUS....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x1D) // Subtract the data on the BUS from the
@@ -516,8 +1068,8 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: SUBTRACT \n");
-            printf("Subtracting ACC and BUS....\n");
+            trace("Instruction \t: SUBTRACT \n");
+            trace("Subtracting ACC and BUS....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if(inst_code==0x1E) // Adds the data on the BUS to ACC register, sum stored to ACC
@@ -531,28 +1083,128 @@ int CU()
             if(Memory)
                 BUS = MBR; // load data on BUS to MBR (ACC high byte
             ALU();
-            printf("Instruction \t: ADD \n");
-            printf("Adding ACC and BUS....\n");
+            trace("Instruction \t: ADD \n");
+            trace("Adding ACC and BUS....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
         }
         else if (inst_code==0x1F) // End of Program
         {
-            result = 1;
-            printf("Instruction \t: EOP \n");
-            printf("Program Ended....\n");
+            result = RUN_EOP;
+            trace("Instruction \t: EOP \n");
+            trace("Program Ended....\n");
             displayData(PC, MAR, IOAR, IOBR, IR, inst_code, CONTROL, BUS, ADDR, operand); // New Changes to displayData call
             // Added IR, inst_code, control, bus, addr
             isEOP = true;
-            getchar();
+            if(!quiet)
+                getchar();
             break;
         }
         // Printing the flags
         // printf("\nFlags: ");
         // printf("\tSF: %d\n\tCF: %d\n\tZF: %d\n\tOF: %d\n\n", SF, CF, ZF, OF);
+
+        /* idle loop detection on taken backward branches */
+        if((inst_code == 0x03 || (inst_code >= 0x11 && inst_code <= 0x14)) && PC <= instAddress)
+        {
+            unsigned int state[9] = {PC, ACC, FLAGS, MBR, IOBR, MAR, IOAR, BUS, CONTROL};
+
+            if(PC == loopPC && writeCount == loopWrites && memcmp(state, loopState, sizeof(state)) == 0
+               && (!inputOpen || inputEOF)) // a loop polling the input may still get a byte
+            {
+                // every iteration repeats the same state, so only a budget or an event can end it
+                periods = idlePeriods(instructionCount - loopInstructions, cycleCount - loopCycles);
+                if(periods == NO_EVENT)
+                {
+                    trace("Idle loop at 0x%03x, nothing can change its state\n", PC);
+                    result = RUN_IDLE;
+                    break;
+                }
+                if(chipStatsEnabled || dramEnabled || instructionCache.enabled || dataCache.enabled)
+                    periods = 0; // skipped iterations would miss the heatmap, row buffer and cache statistics
+                instructionCount += periods * (instructionCount - loopInstructions);
+                // from here the loop runs normally up to the budget or the event
+                idleCycles += periods * (cycleCount - loopCycles);
+                cycleCount += periods * (cycleCount - loopCycles);
+                if(periods > 0)
+                    trace("Idle loop at 0x%03x, skipped %llu iterations\n", PC, periods);
+            }
+            loopPC = PC;
+            memcpy(loopState, state, sizeof(state));
+            loopInstructions = instructionCount;
+            loopCycles = cycleCount;
+            loopWrites = writeCount;
+        }
     }
     return result;
 }
 
+/*===============================================
+*   FUNCTION    :   instructionCycles
+*   DESCRIPTION :   Cycles CU() spends on an instruction, coreCycles[] of
+*                   CORE/Core.h: 2 fetch cycles plus the execute cycles of TRACS
+*                   figure 4.
+*   ARGUMENTS   :   UNSIGNED INT inst_code
+*   RETURNS     :   UNSIGNED INT
+ *==============================================*/
+unsigned int instructionCycles(unsigned int inst_code)
+{
+    return coreCycles[inst_code & 0x1F];
+}
+
+/*===============================================
+*   FUNCTION    :   idlePeriods
+*   DESCRIPTION :   Number of whole iterations of an idle loop that fit before the
+*                   instruction or cycle budget runs out or the next device
+*                   event is due.
+*   ARGUMENTS   :   UNSIGNED LONG LONG period (instructions per iteration), cycles
+*   RETURNS     :   UNSIGNED LONG LONG (NO_EVENT if nothing ever ends the loop)
+ *==============================================*/
+unsigned long long idlePeriods(unsigned long long period, unsigned long long cycles)
+{
+    unsigned long long periods = NO_EVENT, n;
+
+    if(instructionBudget)
+        periods = instructionCount < instructionBudget ? (instructionBudget - instructionCount) / period : 0;
+    if(cycleBudget)
+    {
+        n = cycleCount < cycleBudget ? (cycleBudget - cycleCount) / cycles : 0;
+        if(n < periods)
+            periods = n;
+    }
+    if(nextEventCycle != NO_EVENT)
+    {
+        n = cycleCount < nextEventCycle ? (nextEventCycle - cycleCount) / cycles : 0;
+        if(n < periods)
+            periods = n;
+    }
+    return periods;
+}
+
+/*===============================================
+*   FUNCTION    :   wallClock
+*   DESCRIPTION :   Seconds on a monotonic clock for the watchdog and the FPS
+*                   limit. time() only has whole seconds, and clock() is the
+*                   CPU time of the process, which stands still while it waits
+*                   on its input.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   DOUBLE
+ *==============================================*/
+double wallClock(void)
+{
+#ifndef _WIN32
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#else
+    LARGE_INTEGER now, frequency;
+
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    return (double)now.QuadPart / frequency.QuadPart;
+#endif
+}
+
 /*===============================================
 *   FUNCTION    :   displayDataData
 *   DESCRIPTION :   This function displayDatas the data in the CU.
@@ -561,6 +1213,8 @@ int CU()
  *==============================================*/
 void displayData(unsigned int PC, unsigned int MAR, unsigned int IOAR, unsigned int IOBR, unsigned int IR, unsigned int inst_code, unsigned int CONTROL, unsigned int BUS, unsigned int ADDR, unsigned int operand)
 {
+    if (quiet)
+        return;
     printf("\n\t\tData \n");
     printf("MAR \t\t\t: 0x%03x \n", MAR);
     printf("PC \t\t\t\t: 0x%02x \n", PC);
@@ -638,7 +1292,7 @@ void displayMemory(void)
  *==============================================*/
 void initMemory()
 {
-    printf("Initializing Main Memmory...\n\n");
+    trace("Initializing Main Memmory...\n\n");
     IOM = 1, RW = 1, OE = 1;
     ADDR = 0x00; BUS = 0x30; MainMemory();
     ADDR = 0x01; BUS = 0x02; MainMemory();
@@ -686,6 +1340,44 @@ void initMemory()
     ADDR = 0x2b; BUS = 0x00; MainMemory();
 }
 
+/*===============================================
+*   FUNCTION    :   loadImage
+*   DESCRIPTION :   Loads a binary program image into main memory through the
+*                   bus, byte n of the file going to address n.
+*   ARGUMENTS   :   const char *path
+*   RETURNS     :   INT (1 if the image was loaded, 0 otherwise)
+ *==============================================*/
+int loadImage(const char *path)
+{
+    unsigned char image[2048];
+    size_t size, i;
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL)
+    {
+        printf("Error: cannot open image %s\n", path);
+        return 0;
+    }
+    size = fread(image, 1, sizeof(image), fp);
+    if (fgetc(fp) != EOF)
+    {
+        printf("Error: image %s is larger than the 2048 byte main memory\n", path);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+
+    trace("Loading %s (%u bytes) to Main Memory...\n\n", path, (unsigned int)size);
+    IOM = 1, RW = 1, OE = 1;
+    for (i = 0; i < size; i++)
+    {
+        ADDR = (unsigned int)i;
+        BUS = image[i];
+        MainMemory();
+    }
+    return 1;
+}
+
 /*===============================================
 *   FUNCTION    :   MainMemory
 *   DESCRIPTION :   This function reads or writes from or onto MainMemory.
@@ -694,10 +1386,8 @@ void initMemory()
  *==============================================*/
 void MainMemory(void)
 {
-    int row, col, i;
+    int row, col;
 	short int cs; // chip select
-    unsigned char final = 0;
-	int* binary = NULL;
 
 	if(OE && IOM == 1)
     {
@@ -705,423 +1395,1276 @@ void MainMemory(void)
         col = ADDR & 0x001F;
         row = (ADDR >> 5) & 0x001F;
         cs = ADDR >> 10;
+        if(chipStatsEnabled)
+        {
+            int group = cs != 0; // past 0x7FF is still group B, like the read and write below
+
+            if(RW == 0)
+                chipReads[group][row][col]++;
+            else
+                chipWrites[group][row][col]++;
+            if(lastRow[group] != row)
+                rowActivations[group]++;
+            lastRow[group] = row;
+        }
+        if(!dramBypass)
+            cycleCount += dramLatency(ADDR);
 
         if(RW == 0) // memory read
         {
-            unsigned char result[8] = {0, 0, 0, 0, 0, 0, 0, 0};
             if(!cs)
-            {
-                result[7] = getBit(A1[row], col);
-                result[6] = getBit(A2[row], col);
-                result[5] = getBit(A3[row], col);
-                result[4] = getBit(A4[row], col);
-                result[3] = getBit(A5[row], col);
-                result[2] = getBit(A6[row], col);
-                result[1] = getBit(A7[row], col);
-                result[0] = getBit(A8[row], col);
-            }
+                BUS = chipRead(chipsA, ADDR);
+            else if(bankPlanes[0] != NULL) // selected bank
+                BUS = chipRead(bankPlanes, ADDR);
             else
-            {
-                result[7] = getBit(B1[row], col);
-                result[6] = getBit(B2[row], col);
-                result[5] = getBit(B3[row], col);
-                result[4] = getBit(B4[row], col);
-                result[3] = getBit(B5[row], col);
-                result[2] = getBit(B6[row], col);
-                result[1] = getBit(B7[row], col);
-                result[0] = getBit(B8[row], col);
-            }
-
-            for (i = 0; i < 8; i++)
-                final |= result[i] << (8 - i - 1);
-
-            BUS = final; // reconstruct the data from memory
+                BUS = 0x00; // a bank that was never written
         }
         else if(RW == 1)
         {
-            // unsigned char* temp = charToBinary(BUS);
-            unsigned char* temp = charToBinary((unsigned char)BUS);
-            binary = (int*)temp;
             if(!cs)
-            {
-                setBit(&A1[row], col, binary[0]);
-                setBit(&A2[row], col, binary[1]);
-                setBit(&A3[row], col, binary[2]);
-                setBit(&A4[row], col, binary[3]);
-                setBit(&A5[row], col, binary[4]);
-                setBit(&A6[row], col, binary[5]);
-                setBit(&A7[row], col, binary[6]);
-                setBit(&A8[row], col, binary[7]);
-            }
-            else
-            {
-                setBit(&B1[row], col, binary[0]);
-                setBit(&B2[row], col, binary[1]);
-                setBit(&B3[row], col, binary[2]);
-                setBit(&B4[row], col, binary[3]);
-                setBit(&B5[row], col, binary[4]);
-                setBit(&B6[row], col, binary[5]);
-                setBit(&B7[row], col, binary[6]);
-                setBit(&B8[row], col, binary[7]);
-            }
-            free(temp);
+                chipWrite(chipsA, ADDR, BUS);
+            else if(bankPlanes[0] != NULL || bankAllocate()) // selected bank
+                chipWrite(bankPlanes, ADDR, BUS);
         }
+        if(cosimEnabled && (!cs || bankSelected == 0))
+            cosimAccess(); // the same access on LE5's flat memory
 	}
 }
 
 /*===============================================
-*   FUNCTION    :   setBit
-*   DESCRIPTION :   This function sets the bit at the given position.
-*   ARGUMENTS   :   long*, int, int
-*   RETURNS     :   VOID
+*   FUNCTION    :   cacheConfigure
+*   DESCRIPTION :   Sets up a cache from "size,line,ways[,policy[,penalty]]",
+*                   sizes in bytes and powers of two, policy lru, fifo or
+*                   random. 2048,1,1 already holds the whole memory.
+*   ARGUMENTS   :   Cache *cache, const char *spec
+*   RETURNS     :   INT (1 if the cache was set up, 0 otherwise)
  *==============================================*/
-void setBit(long* num, int pos, int value)
+int cacheConfigure(Cache *cache, const char *spec)
 {
-    if (value == 0)
-        *num &= ~(1u << pos); // Clear the bit at the given position
+    unsigned int size = 0, line = 0, ways = 0, penalty = CACHE_PENALTY, sets;
+    char policy[8] = "lru";
+    int fields = sscanf(spec, "%u,%u,%u,%7[a-z],%u", &size, &line, &ways, policy, &penalty);
+
+    sets = line && ways ? size / line / ways : 0;
+    if (fields < 3 || sets == 0 || size > CACHE_MAX_LINES * line || size != sets * line * ways
+        || (line & (line - 1)) || (sets & (sets - 1)) || line > 2048)
+    {
+        printf("Error: %s needs size,line,ways[,lru|fifo|random[,penalty]] with power of two sizes, got %s\n", cache->name, spec);
+        return 0;
+    }
+    if (strcmp(policy, "lru") == 0)
+        cache->policy = CACHE_LRU;
+    else if (strcmp(policy, "fifo") == 0)
+        cache->policy = CACHE_FIFO;
+    else if (strcmp(policy, "random") == 0)
+        cache->policy = CACHE_RANDOM;
     else
-        *num |= (1u << pos);  // Set the bit at the given position
+    {
+        printf("Error: unknown replacement policy %s\n", policy);
+        return 0;
+    }
+    for (cache->lineShift = 0; (1u << cache->lineShift) < line; cache->lineShift++)
+        ;
+    cache->setMask = sets - 1;
+    for (cache->tagShift = cache->lineShift; (1u << (cache->tagShift - cache->lineShift)) < sets; cache->tagShift++)
+        ;
+    cache->ways = ways;
+    cache->penalty = penalty;
+    cache->enabled = true;
+    return 1;
 }
 
 /*===============================================
-*   FUNCTION    :   getBit
-*   DESCRIPTION :   This function gets the bit at the given position.
-*   ARGUMENTS   :   long, int
-*   RETURNS     :   INT
+*   FUNCTION    :   cacheAccess
+*   DESCRIPTION :   Looks the line of address up in its set. A miss fills the
+*                   invalid or victim way and charges the miss penalty (the
+*                   cacheMissPenalty hook if set) to the cycle count.
+*   ARGUMENTS   :   Cache *cache, UNSIGNED INT address
+*   RETURNS     :   BOOL (true on a hit)
  *==============================================*/
-int getBit(long num, int pos)
+bool cacheAccess(Cache *cache, unsigned int address)
 {
-    return (num >> pos) & 1;
-}
+    unsigned int base = ((address >> cache->lineShift) & cache->setMask) * cache->ways;
+    unsigned int tag = address >> cache->tagShift, way, victim = base, penalty;
 
-/*===============================================
-*   FUNCTION    :   charToBinary
-*   DESCRIPTION :   This function converts a char to binary.
-*   ARGUMENTS   :   UNSIGNED CHAR
-*   RETURNS     :   INT*
- *==============================================*/
-int* charToBinary(unsigned char num)
-{
-    int i;
-    int* bits = (int*)malloc(8 * sizeof(int)); // Allocate memory for 8 bits
-    if (bits == NULL)
+    cache->clock++;
+    for (way = base; way < base + cache->ways; way++)
     {
-        printf("Error: memory allocation failed\n");
-        return NULL;
+        if (cache->valid[way] && cache->tag[way] == tag)
+        {
+            cache->hits++;
+            if (cache->policy == CACHE_LRU)
+                cache->stamp[way] = cache->clock;
+            return true;
+        }
+        if (!cache->valid[way])
+            victim = way; // an empty way is always taken
+        else if (cache->valid[victim] && cache->stamp[way] < cache->stamp[victim])
+            victim = way; // oldest use (LRU) or oldest fill (FIFO)
     }
-
-    for (i = 7; i >= 0; i--)
-        bits[i] = (num >> i) & 1; // Get the bit at the ith position
-    return bits;
+    if (cache->valid[victim])
+    {
+        if (cache->policy == CACHE_RANDOM)
+        {
+            cacheSeed ^= cacheSeed << 13;
+            cacheSeed ^= cacheSeed >> 17;
+            cacheSeed ^= cacheSeed << 5;
+            victim = base + cacheSeed % cache->ways;
+        }
+        cache->evictions++;
+    }
+    cache->valid[victim] = true;
+    cache->tag[victim] = tag;
+    cache->stamp[victim] = cache->clock;
+    cache->misses++;
+    penalty = cacheMissPenalty != NULL ? cacheMissPenalty(cache, address) : cache->penalty;
+    cache->penaltyCycles += penalty;
+    cycleCount += penalty;
+    return false;
 }
 
-
 /*===============================================
-*   FUNCTION    :   IOMemory
-*   DESCRIPTION :   This function reads or writes from or onto IOMemory.
-*   ARGUMENTS   :   VOID
+*   FUNCTION    :   cacheReport
+*   DESCRIPTION :   Prints the counters of an enabled cache.
+*   ARGUMENTS   :   Cache *cache
 *   RETURNS     :   VOID
  *==============================================*/
-void IOMemory(void)
+void cacheReport(Cache *cache)
 {
-    if(OE) // check if output is enabled
-    {
-        if(RW && !IOM) // check if memory write and IO Memory access
-        {
-            if(ADDR >= 0x000 && ADDR <= 0x00F) // check the address if valid
-            iOData[ADDR] = BUS; // write data in BUS to IO Memory
-        }
-        else
-        {
-            if(ADDR >= 0x010 && ADDR <= 0x01F) // check the address if valid
-            BUS = iOData[ADDR]; // load data to BUS
-        }
-    }
+    unsigned long long accesses = cache->hits + cache->misses;
+
+    if (!cache->enabled)
+        return;
+    printf("%s: %llu hits, %llu misses (%.2f%% hit rate), %llu evictions, %llu penalty cycles\n",
+           cache->name, cache->hits, cache->misses, accesses ? 100.0 * cache->hits / accesses : 0.0,
+           cache->evictions, cache->penaltyCycles);
 }
 
 
 /*===============================================
-*   FUNCTION    :   ALU
-*   DESCRIPTION :   ALU FUNCTION
-*   ARGUMENTS   :   UNSIGNED CHAR, UNSIGNED CHAR, UNSIGNED CHAR
-*   RETURNS     :   INT
+*   FUNCTION    :   dramLatency
+*   DESCRIPTION :   Extra cycles of a chip access under the row buffer model,
+*                   and opens the row of address in its group.
+*   ARGUMENTS   :   UNSIGNED INT address
+*   RETURNS     :   UNSIGNED INT
  *==============================================*/
-int ALU(void)
+unsigned int dramLatency(unsigned int address)
 {
-    printf("\n");
-    /* setting ACC and flags to initial values */
-    static unsigned int ACC = 0x0000;
-    unsigned char temp_ACC = 0x0000;
-    unsigned char temp_OP1, temp_OP2, temp_prod;
-    unsigned int n = 0, Q_n1 = 0;
-    SF=0, CF=0, ZF=0, OF=0;
+    int row = (address >> 5) & 0x1F, cs = (address >> 10) & 0x1;
+    unsigned int cycles = 0;
 
-    // printf("\nACC = "); printBin(ACC, 16);
-    if(CONTROL == subtraction || CONTROL == addition) // Checking if addition or subtraction
-    {
-        if(CONTROL == subtraction)
-        {
-            temp_OP2 = BUS;
-            temp_OP2 = twosComp(BUS); //000 0000 0010 00110
-            printf("\n SUBTRACTION <--- ALU\n");
-        }
-        else // Addition
-        {
-            temp_OP2 = BUS;
-            printf("\nADDITION <--- ALU\n");
-        }
-        temp_ACC = (0x00FF & ACC) + temp_OP2;
-        ACC = (unsigned char) temp_ACC;
-        // checking to see if ACC is 0
-        if (ACC == 0)
-            ZF = 1;
-        else
-            ZF = 0;
-    }
-    else if(CONTROL == multiplication) // Multiplication
-    { // Implementing Booths algorithm
-        boothsAlogrithm(ACC, BUS);
-        printf("\nMULTIPLICATION <--- ALU\n");
-    }
-    else if(CONTROL == AND)
-    {
-        // Performing AND
-        ACC = ACC & BUS;
-        if (ACC == 0)
-            FLAGS = FLAGS | ZF;
-        else
-            FLAGS = FLAGS & ~ZF;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nAND <--- ALU\n");
-    }
-    else if(CONTROL == OR)
-    {
-        // Performing OR
-        ACC = ACC | BUS;
-        if (ACC == 0)
-            FLAGS = FLAGS | ZF;
-        else
-            FLAGS = FLAGS & ~ZF;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nOR <--- ALU\n");
-    }
-    else if(CONTROL == NOT)
-    {
-        // Performing NOT
-        ACC = ~ACC;
-        if (ACC == 0)
-            FLAGS = FLAGS | ZF;
-        else
-            FLAGS = FLAGS & ~ZF;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nNOT <--- ALU\n");
-    }
-    else if(CONTROL == XOR)
-    {
-        // Performing XOR
-        temp_OP2 = BUS;
-        ACC = ACC ^ temp_OP2;
-        if (ACC == 0)
-            FLAGS = FLAGS | ZF;
-        else
-            FLAGS = FLAGS & ~ZF;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nXOR <--- ALU\n");
-    }
-    else if(CONTROL == shift_left)
-    {
-        // Performing Shift Left
-        FLAGS = FLAGS & ~CF;    //Clearing CF Flag
-        if ((ACC & 0x8000) == 0x8000)
-            FLAGS = FLAGS | CF;     //Set CF Flag
-        else
-            FLAGS = FLAGS & ~CF; //Clear CF Flag
-        ACC = ACC << 1;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nSHIFT LEFT <--- ALU\n");
-    }
-    else if(CONTROL == shift_right)
-    {
-        // Performing Shift Right
-        FLAGS = FLAGS & ~CF;
-        if (0x01 & ACC)
-            FLAGS = FLAGS | CF;
-        else
-            FLAGS = FLAGS & ~CF;
-        ACC = ACC >> 1;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nSHIFT RIGHT <--- ALU\n");
-    }
-    else if(CONTROL == WACC)
+    if(dramLastGroup >= 0 && dramLastGroup != cs)
     {
-        // Write data on BUS to ACC
-        ACC = (ACC & 0xFF00) | BUS;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nWACC <--- ALU\n");
+        dramSwitches++;
+        cycles += dramSwitch;
     }
-    else if(CONTROL == RACC)
+    if(dramOpenRow[cs] == row)
     {
-        // Move ACC data to BUS
-        BUS = ACC & 0x00FF;
-        printf("\nACC = "); printBin(ACC, 16);
-        printf("\nRACC <--- ALU\n");
+        dramHits++;
+        cycles += dramRowHit;
     }
     else
     {
-        printf("\nInvalid Control Signal");
-        // Printing the control signal
-        printf("\nControl Signal: ");
-        printBin(CONTROL, 8);
-        getchar();
+        dramMisses++;
+        cycles += dramRowMiss;
     }
-    printf("\nACC = "); printBin(ACC, 16);
-    printf("\n");
-    setFlags(ACC);
+    dramOpenRow[cs] = row;
+    dramLastGroup = cs;
+    dramCycles += cycles;
+    return cycles;
 }
 
 /*===============================================
-*   FUNCTION    :   boothsAlogrithm
-*   DESCRIPTION :   Performs multiplication using Booth's algorithm
-*   ARGUMENTS   :   UNSIGNED INT, UNSIGNED CHAR, UNSIGNED CHAR
-*   RETURNS     :   VOID
+*   FUNCTION    :   dramCachePenalty
+*   DESCRIPTION :   cacheMissPenalty hook of -M: a line fill pays the cache's
+*                   penalty plus the row buffer latency of the line.
+*   ARGUMENTS   :   Cache *cache, UNSIGNED INT address
+*   RETURNS     :   UNSIGNED INT
  *==============================================*/
-void boothsAlogrithm(unsigned char M, unsigned char Q) {  // Q Multiplier and M Multiplicand
-    int n;
-    unsigned char Q_N1 = 0;
-    unsigned char A = 0x00;
-    // unsigned char LSB_Q = Q & 0x01;
-    printf("\nA\t\t\tQ\t\t\tQn-1\tM\t    Cycle\n");
-    for(n = 0; n < 8; n++){
-        displayStep(A, Q, Q_N1, M, n);
-        unsigned char MSB_A;
-        unsigned char LSB_Q = Q & 0x01;
-        unsigned char LSB_A = A & 0x01;
-        // Check if the LSB of Q and Q_N1 are different
-        if(LSB_Q == 1 && Q_N1 == 0)     // 10 Q LSB_Q
-            A = A + twosComp(M);
-        else if(LSB_Q == 0 && Q_N1 == 1) // 01
-            A = A + M;
-        MSB_A = A & 0x80;
-        // Shift Right, Add Zero to MSB OF A
-        A >>= 1;           // Shift A one bit to the Right
-        A &= 0x7F;         // Clear the MSB of A
-        // Set the MSB of A based on the saved MSB_A
-        if (MSB_A != 0) A |= 0x80;
-        // Shift Q one bit to the Right
-        Q >>= 1;
-        Q |= (LSB_A << 7); // Set the LSB of Q to the LSB of A
-        Q_N1 = LSB_Q; // Set Q_N1 to the LSB of Q for next cycle
-    }
-    displayStep(A, Q, Q_N1, M, 8);
-    // Lastly we merge A and Q to get the result and then print the binary of 16 bits
-    unsigned int result = (A << 8) | Q;
-    printf("ACC = ");
-    printBin(result, 16);
+unsigned int dramCachePenalty(Cache *cache, unsigned int address)
+{
+    return cache->penalty + dramLatency(address & ~((1u << cache->lineShift) - 1));
 }
 
 /*===============================================
-*   FUNCTION    :   displayStep
-*   DESCRIPTION :   Displays the current state of the registers
-*   ARGUMENTS   :   UNSIGNED CHAR, UNSIGNED CHAR, UNSIGNED CHAR, UNSIGNED CHAR, INT
+*   FUNCTION    :   cosimAccess
+*   DESCRIPTION :   The access MainMemory() just made, on the flat memory of
+*                   LE5: a write is copied, a read is compared with what the
+*                   chips put on the BUS. The first difference is kept for
+*                   cosimReport(), CU() stops before the next instruction.
+*   ARGUMENTS   :   VOID (ADDR, RW and BUS of the access)
 *   RETURNS     :   VOID
  *==============================================*/
-void displayStep(unsigned char A, unsigned char Q, unsigned char Q_N1, unsigned char M, int n)
+void cosimAccess(void)
 {
-    printBin(A, 8);
-    printf("\t");
-    printBin(Q, 8);
-    printf("\t");
-    printBin(Q_N1, 1);
-    printf("\t");
-    printBin(M, 8);
-    printf("\t");
-    printf("%d", n);
-    printf("\n");
+    MemoryAccess *access = &cosimHistory[cosimCount++ % COSIM_HISTORY];
+    unsigned char flat = ADDR < sizeof(dataMemory) ? dataMemory[ADDR] : 0;
+
+    access->cycle = cycleCount;
+    access->address = ADDR;
+    access->value = BUS;
+    access->write = RW;
+    if(RW)
+    {
+        if(ADDR < sizeof(dataMemory))
+            dataMemory[ADDR] = BUS;
+        return;
+    }
+    cosimReads++;
+    if(!cosimDiverged && (flat != BUS || ADDR >= sizeof(dataMemory))) // LE5 has no cell past 0x7FF
+    {
+        cosimDiverged = true;
+        cosimAddress = ADDR;
+        cosimChips = BUS;
+        cosimFlat = flat;
+    }
 }
 
 /*===============================================
-*   FUNCTION    :   setFlags
-*   DESCRIPTION :   Sets the flags based on the result of the operation
-*   ARGUMENTS   :   UNSIGNED INT
+*   FUNCTION    :   cosimReport
+*   DESCRIPTION :   Prints the first divergence of the co-simulation with the
+*                   instruction it happened in and the accesses before it.
+*   ARGUMENTS   :   UNSIGNED INT instAddress, UNSIGNED INT IR
 *   RETURNS     :   VOID
  *==============================================*/
-void setFlags(unsigned int ACC)
+void cosimReport(unsigned int instAddress, unsigned int IR)
 {
-    // Conditions where Zero flag is set:
-    unsigned char tmp_ACC = ACC;
-    if (CONTROL == addition || CONTROL == subtraction)
-    {
-        if (ACC == 0x0000) // Conditions where Zero flag is set:
-            FLAGS = FLAGS | ZF;
-        else
-            FLAGS = FLAGS & ~ZF;
-
-        //check if sign flag
-        if ((ACC & 0x8000) == 0x8000)
-            FLAGS = FLAGS | SF;
-        else
-            FLAGS = FLAGS & ~SF;
-
-        //check if overflow flag
-        if (ACC > 0x7FFF)
-            FLAGS = FLAGS | OF;
-        else
-            FLAGS = FLAGS & ~OF;
-
-        //check if carry flag
-        if (ACC > 0xFFFF)
-            FLAGS = FLAGS | CF;
-        else
-            FLAGS = FLAGS & ~CF;
-
+    unsigned int i, first = cosimCount > COSIM_HISTORY ? cosimCount - COSIM_HISTORY : 0;
 
-    } else if (CONTROL == multiplication){
-
-        //check zero flag
-        if (ACC == 0x0000)
-            FLAGS = FLAGS | ZF;
-        else
-            FLAGS = FLAGS & ~ZF;
-
-        //check sign flag
-        if ((ACC & 0x8000) == 0x8000)
-            FLAGS = FLAGS | SF;
-        else
-            FLAGS = FLAGS & ~SF;
-
-        //check overflow flag
-        if (ACC > 0xFF)
-            FLAGS = FLAGS | OF;
-        else
-            FLAGS = FLAGS & ~OF;
-
-        //check carry flag
-        if (ACC > 0xFF)
-            FLAGS = FLAGS | CF;
-        else
-            FLAGS = FLAGS & ~CF;
+    printf("\nCo-simulation: the chips and the flat memory differ at read %llu, instruction %llu (cycle %llu)\n",
+           cosimReads, instructionCount, cycleCount);
+    printf("Instruction at 0x%03x, IR 0x%04x\n", instAddress, IR);
+    if(cosimAddress >= sizeof(dataMemory))
+        printf("ADDR 0x%03x: chips 0x%02x, the flat memory has no such cell\n", cosimAddress, cosimChips);
+    else
+        printf("ADDR 0x%03x (chip group %c, row %u, column %u): chips 0x%02x, flat memory 0x%02x\n",
+               cosimAddress, (cosimAddress >> 10) ? 'B' : 'A', (cosimAddress >> 5) & 0x1F, cosimAddress & 0x1F,
+               cosimChips, cosimFlat);
+    printf("Last accesses:\n");
+    for(i = first; i < cosimCount; i++)
+    {
+        MemoryAccess *access = &cosimHistory[i % COSIM_HISTORY];
+        printf("  cycle %llu: %s 0x%03x = 0x%02x\n", access->cycle,
+               access->write ? "write" : "read ", access->address, access->value);
     }
 }
 
 /*===============================================
-*   FUNCTION    :   twosComp
-*   DESCRIPTION :   Returns the two's complement of a number
-*   ARGUMENTS   :   UNSIGNED CHAR
-*   RETURNS     :   UNSIGNED CHAR
+*   FUNCTION    :   heatmapWrite
+*   DESCRIPTION :   Writes the chip access counts to prefix.csv (group, row,
+*                   column, reads, writes) and prefix.ppm (group A left of
+*                   group B, a row per chip row, reads in green and writes in
+*                   red on a log scale), and prints the row activations.
+*   ARGUMENTS   :   const char *prefix
+*   RETURNS     :   INT (1 if both files were written, 0 otherwise)
  *==============================================*/
-unsigned char twosComp(unsigned char operand)
+int heatmapWrite(const char *prefix)
 {
-    return ~operand + 1;
-}
+    char path[1024];
+    FILE *csv, *ppm;
+    unsigned long long most = 0, reads, writes;
+    int cs, row, col, ok;
+
+    snprintf(path, sizeof(path), "%s.csv", prefix);
+    csv = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.ppm", prefix);
+    ppm = fopen(path, "wb");
+    if (csv == NULL || ppm == NULL)
+    {
+        printf("Error: cannot create heatmap %s.csv/.ppm\n", prefix);
+        if (csv != NULL)
+            fclose(csv);
+        if (ppm != NULL)
+            fclose(ppm);
+        return 0;
+    }
 
-/*===============================================
-*   FUNCTION    :   printBin
+    fprintf(csv, "group,row,col,reads,writes\n");
+    for (cs = 0; cs < CHIP_GROUPS; cs++)
+        for (row = 0; row < CHIP_ROWS; row++)
+            for (col = 0; col < CHIP_COLS; col++)
+            {
+                reads = chipReads[cs][row][col];
+                writes = chipWrites[cs][row][col];
+                if (reads > most)
+                    most = reads;
+                if (writes > most)
+                    most = writes;
+                if (reads > 0 || writes > 0)
+                    fprintf(csv, "%c,%d,%d,%llu,%llu\n", 'A' + cs, row, col, reads, writes);
+            }
+
+    fprintf(ppm, "P6\n%d %d\n255\n", CHIP_GROUPS * CHIP_COLS + 1, CHIP_ROWS);
+    for (row = 0; row < CHIP_ROWS; row++)
+        for (cs = 0; cs < CHIP_GROUPS; cs++)
+        {
+            if (cs > 0)
+                fputc(0x40, ppm), fputc(0x40, ppm), fputc(0x40, ppm); // gray line between the groups
+            for (col = 0; col < CHIP_COLS; col++)
+            {
+                fputc(most ? (int)(255 * log1p((double)chipWrites[cs][row][col]) / log1p((double)most)) : 0, ppm);
+                fputc(most ? (int)(255 * log1p((double)chipReads[cs][row][col]) / log1p((double)most)) : 0, ppm);
+                fputc(0, ppm);
+            }
+        }
+
+    ok = !ferror(csv) && !ferror(ppm);
+    ok = (fclose(csv) == 0) & (fclose(ppm) == 0) & ok;
+    if (!ok)
+    {
+        printf("Error: cannot write heatmap %s.csv/.ppm\n", prefix);
+        return 0;
+    }
+    printf("Row activations: %llu in chip group A, %llu in chip group B\n", rowActivations[0], rowActivations[1]);
+    return 1;
+}
+
+/*===============================================
+*   FUNCTION    :   IOMemory
+*   DESCRIPTION :   This function reads or writes from or onto IOMemory. The
+*                   device owning ADDR is looked up in ioMap, unmapped
+*                   addresses and missing callbacks leave everything as is.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void IOMemory(void)
+{
+    IODevice *device;
+
+    if(OE && ADDR < IO_SPACE && (device = ioMap[ADDR]) != NULL) // check if output is enabled and the address is valid
+    {
+        if(RW && !IOM) // check if memory write and IO Memory access
+        {
+            if(device->write != NULL)
+                device->write(ADDR - device->base, BUS); // write data in BUS to the device
+        }
+        else if(device->read != NULL)
+            BUS = device->read(ADDR - device->base); // load data to BUS
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   IORegister
+*   DESCRIPTION :   Maps a device on size addresses from base. Ranges can't
+*                   overlap, the first device keeps its addresses.
+*   ARGUMENTS   :   const char *name, UNSIGNED INT base, UNSIGNED INT size, read and write callbacks
+*   RETURNS     :   INT (1 if the device was registered, 0 otherwise)
+ *==============================================*/
+int IORegister(const char *name, unsigned int base, unsigned int size,
+               unsigned char (*read)(unsigned int offset), void (*write)(unsigned int offset, unsigned char data))
+{
+    IODevice *device;
+    unsigned int i;
+
+    if(ioDeviceCount == MAX_IO_DEVICES || size == 0 || base + size > IO_SPACE)
+    {
+        printf("Error: cannot register IO device %s at 0x%03x\n", name, base);
+        return 0;
+    }
+    for(i = base; i < base + size; i++)
+        if(ioMap[i] != NULL)
+        {
+            printf("Error: IO device %s overlaps %s at 0x%03x\n", name, ioMap[i]->name, i);
+            return 0;
+        }
+    device = &ioDevices[ioDeviceCount++];
+    device->name = name;
+    device->base = base;
+    device->size = size;
+    device->read = read;
+    device->write = write;
+    for(i = base; i < base + size; i++)
+        ioMap[i] = device;
+    return 1;
+}
+
+/*===============================================
+*   FUNCTION    :   IOInit
+*   DESCRIPTION :   Registers the standard devices: the seven segment display
+*                   at 0x000, output latches up to 0x00F, the input stream at
+*                   0x010 - 0x012 and input latches up to 0x01F.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void IOInit(void)
+{
+    IORegister("seven segment", 0x000, 1, NULL, SevenSegmentWrite);
+    IORegister("output latches", 0x001, 0x00F, NULL, latchWrite);
+    IORegister("input stream", INPUT_DATA, 3, InputSimRead, NULL);
+    IORegister("input latches", 0x013, 0x00D, latchRead, NULL);
+    IORegister("interrupt controller", IRQ_PENDING, 4, interruptRead, interruptWrite);
+    IORegister("DMA", DMA_IO_LO, 6, DMARead, DMAWrite);
+    IORegister("timer", TIMER_RELOAD_LO, 7, timerRead, timerWrite);
+    IORegister("bank select", BANK_SELECT, 1, bankRead, bankWrite);
+    IORegister("counter", COUNTER_LO, 2, counterRead, counterWrite);
+    IORegister("byte pipe", UART_DATA, 2, uartRead, uartWrite);
+}
+
+/*===============================================
+*   FUNCTION    :   bankRead / bankWrite
+*   DESCRIPTION :   Bank select register. Switching banks changes what the
+*                   addresses mean, so the cache models forget their lines
+*                   and the row buffer of group B is closed.
+*   ARGUMENTS   :   UNSIGNED INT offset, UNSIGNED CHAR data
+*   RETURNS     :   UNSIGNED CHAR / VOID
+ *==============================================*/
+unsigned char bankRead(unsigned int offset)
+{
+    (void)offset; // one register
+    return bankSelected;
+}
+
+void bankWrite(unsigned int offset, unsigned char data)
+{
+    int i;
+
+    (void)offset;
+    if(data == bankSelected)
+        return;
+    bankSelected = data;
+    for(i = 0; i < 8; i++)
+        bankPlanes[i] = data == 0 ? bankZero[i] : banks[data] != NULL ? (*banks[data])[i] : NULL;
+    memset(instructionCache.valid, 0, sizeof(instructionCache.valid));
+    memset(dataCache.valid, 0, sizeof(dataCache.valid));
+    dramOpenRow[1] = -1;
+}
+
+/*===============================================
+*   FUNCTION    :   bankAllocate
+*   DESCRIPTION :   Allocates the chips of the selected bank on its first write.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   BOOL (false if out of memory, the write is lost)
+ *==============================================*/
+bool bankAllocate(void)
+{
+    int i;
+
+    banks[bankSelected] = calloc(1, sizeof(BankChips));
+    if(banks[bankSelected] == NULL)
+    {
+        printf("Error: memory allocation failed for bank %u\n", bankSelected);
+        return false;
+    }
+    bankAllocated++;
+    for(i = 0; i < 8; i++)
+        bankPlanes[i] = (*banks[bankSelected])[i];
+    return true;
+}
+
+/*===============================================
+*   FUNCTION    :   scheduleEvent / cancelEvent
+*   DESCRIPTION :   Adds a device event for the given cycle (a handler has at
+*                   most one pending event, scheduling it again moves it) or
+*                   removes it. O(log n) besides finding the handler.
+*   ARGUMENTS   :   UNSIGNED LONG LONG cycle, void (*handler)(void)
+*   RETURNS     :   VOID
+ *==============================================*/
+void scheduleEvent(unsigned long long cycle, void (*handler)(void))
+{
+    cancelEvent(handler);
+    if(eventCount == MAX_EVENTS)
+    {
+        printf("Error: event queue is full\n");
+        return;
+    }
+    events[eventCount].cycle = cycle;
+    events[eventCount].sequence = eventSequence++;
+    events[eventCount].handler = handler;
+    eventUp(eventCount++);
+    nextEventCycle = events[0].cycle;
+}
+
+void cancelEvent(void (*handler)(void))
+{
+    int i;
+
+    for(i = 0; i < eventCount && events[i].handler != handler; i++)
+        ;
+    if(i < eventCount)
+    {
+        events[i] = events[--eventCount];
+        if(i < eventCount)
+        {
+            eventUp(i);
+            eventDown(i);
+        }
+    }
+    nextEventCycle = eventCount > 0 ? events[0].cycle : NO_EVENT;
+}
+
+/*===============================================
+*   FUNCTION    :   runEvents
+*   DESCRIPTION :   Runs every event that is due. CU() calls it between two
+*                   instructions, only when cycleCount reached nextEventCycle,
+*                   so the cost follows the number of events, not cycles.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void runEvents(void)
+{
+    void (*handler)(void);
+
+    while(eventCount > 0 && events[0].cycle <= cycleCount)
+    {
+        handler = events[0].handler;
+        events[0] = events[--eventCount];
+        if(eventCount > 0)
+            eventDown(0);
+        nextEventCycle = eventCount > 0 ? events[0].cycle : NO_EVENT;
+        writeCount++; // device state changed, a loop waiting for it is no longer idle
+        eventsRun++;
+        handler(); // may schedule itself again
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   eventBefore / eventSwap / eventUp / eventDown
+*   DESCRIPTION :   Heap order and sifting of the event kernel.
+*   ARGUMENTS   :   int a, int b / int i (heap positions)
+*   RETURNS     :   BOOL / VOID
+ *==============================================*/
+bool eventBefore(int a, int b)
+{
+    if(events[a].cycle != events[b].cycle)
+        return events[a].cycle < events[b].cycle;
+    return events[a].sequence < events[b].sequence;
+}
+
+void eventSwap(int a, int b)
+{
+    Event temp = events[a];
+
+    events[a] = events[b];
+    events[b] = temp;
+}
+
+void eventUp(int i)
+{
+    while(i > 0 && eventBefore(i, (i - 1) / 2))
+    {
+        eventSwap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+void eventDown(int i)
+{
+    int child;
+
+    while((child = 2 * i + 1) < eventCount)
+    {
+        if(child + 1 < eventCount && eventBefore(child + 1, child))
+            child++;
+        if(!eventBefore(child, i))
+            break;
+        eventSwap(i, child);
+        i = child;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   timerPeriod
+*   DESCRIPTION :   Cycles from reload to expiry.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   UNSIGNED LONG LONG
+ *==============================================*/
+unsigned long long timerPeriod(void)
+{
+    return (unsigned long long)(timerReload ? timerReload : 65536) * (timerPrescaler + 1);
+}
+
+/*===============================================
+*   FUNCTION    :   timerRead / timerWrite
+*   DESCRIPTION :   Registers of the timer. The count is worked out from the
+*                   cycles left to timerDue, the timer never ticks by itself.
+*                   Writing TIMER_CONTROL with TIMER_ENABLE (re)starts a period.
+*   ARGUMENTS   :   UNSIGNED INT offset (from TIMER_RELOAD_LO), UNSIGNED CHAR data
+*   RETURNS     :   UNSIGNED CHAR / VOID
+ *==============================================*/
+unsigned char timerRead(unsigned int offset)
+{
+    unsigned long long ticks = 0;
+
+    if((timerControl & TIMER_ENABLE) && cycleCount < timerDue) // past it, the expiry waits for the instruction to end
+        ticks = (timerDue - cycleCount + timerPrescaler) / (timerPrescaler + 1);
+    if((timerControl & TIMER_ENABLE) && offset + TIMER_RELOAD_LO >= TIMER_COUNT_LO)
+        writeCount++; // the count moves without an event, a loop polling it is not idle
+    switch(offset + TIMER_RELOAD_LO)
+    {
+        case TIMER_RELOAD_LO: return timerReload & 0xFF;
+        case TIMER_RELOAD_HI: return timerReload >> 8;
+        case TIMER_PRESCALER: return (unsigned char)timerPrescaler;
+        case TIMER_CONTROL: return timerControl;
+        case TIMER_STATUS: return timerStatus;
+        case TIMER_COUNT_LO: return ticks & 0xFF;
+        default: return (ticks >> 8) & 0xFF;
+    }
+}
+
+void timerWrite(unsigned int offset, unsigned char data)
+{
+    switch(offset + TIMER_RELOAD_LO)
+    {
+        case TIMER_RELOAD_LO: timerReload = (timerReload & 0xFF00) | data; break;
+        case TIMER_RELOAD_HI: timerReload = (timerReload & 0x00FF) | (data << 8); break;
+        case TIMER_PRESCALER: timerPrescaler = data; break;
+        case TIMER_STATUS: timerStatus &= ~data; break;
+        case TIMER_CONTROL:
+            timerControl = data & (TIMER_ENABLE | TIMER_PERIODIC | TIMER_IRQ);
+            if(timerControl & TIMER_ENABLE)
+            {
+                timerDue = cycleCount + timerPeriod();
+                scheduleEvent(timerDue, timerExpire);
+            }
+            else
+                cancelEvent(timerExpire);
+            break;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   timerExpire
+*   DESCRIPTION :   Timer event: sets the status bit, raises the interrupt and
+*                   schedules the next period of a periodic timer (from the
+*                   due cycle, so the period doesn't drift).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void timerExpire(void)
+{
+    timerStatus |= TIMER_EXPIRED;
+    if(timerControl & TIMER_IRQ)
+        irqPending |= IRQ_TIMER;
+    if(timerControl & TIMER_PERIODIC)
+    {
+        timerDue += timerPeriod();
+        scheduleEvent(timerDue, timerExpire);
+    }
+    else
+        timerControl &= ~TIMER_ENABLE;
+}
+
+/*===============================================
+*   FUNCTION    :   counterRead / counterWrite
+*   DESCRIPTION :   Registers of the free-running counter, worked out from
+*                   cycleCount like the timer count.
+*   ARGUMENTS   :   UNSIGNED INT offset (from COUNTER_LO), UNSIGNED CHAR data
+*   RETURNS     :   UNSIGNED CHAR / VOID
+ *==============================================*/
+unsigned char counterRead(unsigned int offset)
+{
+    unsigned long long count = cycleCount - counterStart;
+
+    writeCount++; // the count moves without an event, a loop polling it is not idle
+    if(offset + COUNTER_LO == COUNTER_HI)
+        return counterLatch;
+    counterLatch = (count >> 8) & 0xFF;
+    return count & 0xFF;
+}
+
+void counterWrite(unsigned int offset, unsigned char data)
+{
+    (void)offset;
+    (void)data;
+    counterStart = cycleCount;
+    counterLatch = 0;
+}
+
+/*===============================================
+*   FUNCTION    :   uartRead / uartWrite
+*   DESCRIPTION :   Registers of the byte pipe. Sending starts shifting the
+*                   byte out unless an earlier one still is, uartShift()
+*                   takes over from there.
+*   ARGUMENTS   :   UNSIGNED INT offset (from UART_DATA), UNSIGNED CHAR data
+*   RETURNS     :   UNSIGNED CHAR / VOID
+ *==============================================*/
+unsigned char uartRead(unsigned int offset)
+{
+    if(offset + UART_DATA == UART_STATUS)
+        return (uartHead != uartArrived ? UART_RECEIVED : 0) | (uartTail - uartHead == UART_QUEUE ? UART_FULL : 0);
+    if(uartHead == uartArrived)
+        return 0x00;
+    writeCount++; // taking a byte changes the pipe, like a write
+    return uartQueue[uartHead++ & (UART_QUEUE - 1)];
+}
+
+void uartWrite(unsigned int offset, unsigned char data)
+{
+    if(offset + UART_DATA != UART_DATA || uartTail - uartHead == UART_QUEUE)
+        return;
+    uartQueue[uartTail++ & (UART_QUEUE - 1)] = data;
+    if(uartTail - uartArrived == 1)
+    {
+        uartDue = cycleCount + UART_BYTE_CYCLES;
+        scheduleEvent(uartDue, uartShift);
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   uartShift
+*   DESCRIPTION :   Byte pipe event: the oldest byte in flight is received,
+*                   the next one starts shifting (from the due cycle, back to
+*                   back).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void uartShift(void)
+{
+    uartArrived++;
+    if(uartArrived != uartTail)
+    {
+        uartDue += UART_BYTE_CYCLES;
+        scheduleEvent(uartDue, uartShift);
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   interruptLines
+*   DESCRIPTION :   Pending lines that are enabled.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   UNSIGNED CHAR
+ *==============================================*/
+unsigned char interruptLines(void)
+{
+    return irqPending & irqMask;
+}
+
+/*===============================================
+*   FUNCTION    :   inputLine
+*   DESCRIPTION :   Sets the input level line from the ring buffer. While the
+*                   line is enabled and the stream is empty but open, an
+*                   inputPoll event reads it again INPUT_POLL_CYCLES later.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void inputLine(void)
+{
+    if(inputHead != inputTail)
+        irqPending |= IRQ_INPUT;
+    else
+    {
+        irqPending &= ~IRQ_INPUT;
+        if((irqMask & IRQ_INPUT) && inputOpen && !inputEOF)
+            scheduleEvent(cycleCount + INPUT_POLL_CYCLES, inputPoll);
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   inputPoll
+*   DESCRIPTION :   Event of an empty input stream with its interrupt enabled.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void inputPoll(void)
+{
+    InputFill();
+    inputLine();
+}
+
+/*===============================================
+*   FUNCTION    :   interruptRead / interruptWrite
+*   DESCRIPTION :   Registers of the interrupt controller.
+*   ARGUMENTS   :   UNSIGNED INT offset (from IRQ_PENDING), UNSIGNED CHAR data
+*   RETURNS     :   UNSIGNED CHAR / VOID
+ *==============================================*/
+unsigned char interruptRead(unsigned int offset)
+{
+    if(offset == 0)
+        return irqPending;
+    if(offset == 1)
+        return irqMask;
+    return offset == 2 ? irqVector & 0xFF : irqVector >> 8;
+}
+
+void interruptWrite(unsigned int offset, unsigned char data)
+{
+    if(offset == 0)
+    {
+        irqPending &= ~data;
+        inputLine(); // level lines come back while their condition holds
+    }
+    else if(offset == 1)
+    {
+        irqMask = data;
+        inputLine();
+    }
+    else if(offset == 2)
+        irqVector = (irqVector & 0x700) | data;
+    else
+        irqVector = (irqVector & 0x0FF) | ((data & 0x07) << 8);
+}
+
+/*===============================================
+*   FUNCTION    :   DMARead / DMAWrite
+*   DESCRIPTION :   Registers of the DMA engine. Writing DMA_CONTROL with
+*                   DMA_START begins a transfer of DMA_COUNT bytes.
+*   ARGUMENTS   :   UNSIGNED INT offset (from DMA_IO_LO), UNSIGNED CHAR data
+*   RETURNS     :   UNSIGNED CHAR / VOID
+ *==============================================*/
+unsigned char DMARead(unsigned int offset)
+{
+    switch(offset + DMA_IO_LO)
+    {
+        case DMA_IO_LO: return dmaIO & 0xFF;
+        case DMA_IO_HI: return dmaIO >> 8;
+        case DMA_MEM_LO: return dmaMem & 0xFF;
+        case DMA_MEM_HI: return dmaMem >> 8;
+        case DMA_COUNT: return dmaCount & 0xFF;
+        default: return dmaControl;
+    }
+}
+
+void DMAWrite(unsigned int offset, unsigned char data)
+{
+    if(dmaControl & DMA_BUSY)
+        return; // registers are locked during a transfer
+    switch(offset + DMA_IO_LO)
+    {
+        case DMA_IO_LO: dmaIO = (dmaIO & 0x700) | data; break;
+        case DMA_IO_HI: dmaIO = (dmaIO & 0x0FF) | ((data & 0x07) << 8); break;
+        case DMA_MEM_LO: dmaMem = (dmaMem & 0x700) | data; break;
+        case DMA_MEM_HI: dmaMem = (dmaMem & 0x0FF) | ((data & 0x07) << 8); break;
+        case DMA_COUNT: dmaCount = data ? data : 256; break;
+        default:
+            dmaControl = data & (DMA_TO_IO | DMA_FIXED_IO | DMA_IRQ);
+            if(data & DMA_START)
+            {
+                dmaControl |= DMA_BUSY;
+                scheduleEvent(cycleCount, DMATransfer); // at the next instruction boundary
+            }
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   DMATransfer
+*   DESCRIPTION :   DMA event: moves one byte over the buses like RIO/WM (or
+*                   RM/WIO) would, then gives the bus back to the CU as it
+*                   found it. The cycles are charged to the run, the CU stalls
+*                   meanwhile. The next byte is scheduled after the CU got
+*                   the bus for one instruction.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void DMATransfer(void)
+{
+    unsigned char savedBUS = BUS, data;
+    unsigned int savedADDR = ADDR;
+    bool savedIOM = IOM, savedRW = RW, savedOE = OE;
+
+    OE = 1;
+    if(dmaControl & DMA_TO_IO)
+    {
+        IOM = 1; RW = 0; ADDR = dmaMem; MainMemory(); // memory read
+        data = BUS;
+        IOM = 0; RW = 1; ADDR = dmaIO; BUS = data; IOMemory(); // IO write
+    }
+    else
+    {
+        IOM = 0; RW = 0; ADDR = dmaIO; IOMemory(); // IO read
+        data = BUS;
+        IOM = 1; RW = 1; ADDR = dmaMem; BUS = data; MainMemory(); // memory write
+    }
+    BUS = savedBUS; ADDR = savedADDR; IOM = savedIOM; RW = savedRW; OE = savedOE;
+
+    writeCount++;
+    cycleCount += DMA_BYTE_CYCLES;
+    dmaCycles += DMA_BYTE_CYCLES;
+    dmaMem = (dmaMem + 1) & 0x7FF;
+    if(!(dmaControl & DMA_FIXED_IO))
+        dmaIO = (dmaIO + 1) & 0x7FF;
+    if(--dmaCount == 0)
+    {
+        dmaControl &= ~DMA_BUSY;
+        if(dmaControl & DMA_IRQ)
+            irqPending |= IRQ_DMA;
+    }
+    else
+        scheduleEvent(cycleCount + DMA_GAP_CYCLES, DMATransfer);
+}
+
+/*===============================================
+*   FUNCTION    :   latchWrite / latchRead
+*   DESCRIPTION :   Plain iOData bytes without a device behind them.
+*   ARGUMENTS   :   UNSIGNED INT offset, UNSIGNED CHAR data
+*   RETURNS     :   VOID / UNSIGNED CHAR
+ *==============================================*/
+void latchWrite(unsigned int offset, unsigned char data)
+{
+    iOData[0x001 + offset] = data;
+}
+
+unsigned char latchRead(unsigned int offset)
+{
+    return iOData[0x013 + offset];
+}
+
+/*===============================================
+*   FUNCTION    :   InputOpen
+*   DESCRIPTION :   Attaches a file, FIFO or stdin ("-") to the input device.
+*                   stdin is shared with the shell, InputClose() gives it its
+*                   blocking mode back at exit.
+*   ARGUMENTS   :   const char *path
+*   RETURNS     :   INT (1 if the input was opened, 0 otherwise)
+ *==============================================*/
+int InputOpen(const char *path)
+{
+#ifdef _WIN32
+    inputFile = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (inputFile == NULL)
+#else
+    struct stat info;
+
+    inputFd = strcmp(path, "-") == 0 ? 0 : open(path, O_RDONLY | O_NONBLOCK);
+    if (inputFd >= 0)
+        inputFlags = fcntl(inputFd, F_GETFL);
+    if (inputFd < 0 || inputFlags < 0 || fcntl(inputFd, F_SETFL, inputFlags | O_NONBLOCK) < 0)
+#endif
+    {
+        printf("Error: cannot open input %s\n", path);
+        return 0;
+    }
+#ifndef _WIN32
+    atexit(InputClose);
+    // a named FIFO opened before its writer reads as end of file, stdin's writer was there first
+    inputWaiting = inputFd != 0 && fstat(inputFd, &info) == 0 && S_ISFIFO(info.st_mode);
+#endif
+    inputOpen = true;
+    inputEOF = false;
+    return 1;
+}
+
+/*===============================================
+*   FUNCTION    :   InputClose
+*   DESCRIPTION :   Restores the file status flags InputOpen() found on the
+*                   input and closes it (stdin is only restored).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void InputClose(void)
+{
+#ifndef _WIN32
+    if (inputFd < 0)
+        return;
+    fcntl(inputFd, F_SETFL, inputFlags);
+    if (inputFd != 0)
+        close(inputFd);
+    inputFd = -1;
+#endif
+}
+
+/*===============================================
+*   FUNCTION    :   InputFill
+*   DESCRIPTION :   Reads as much of the stream as is ready into the free,
+*                   contiguous part of the ring buffer. Only called when the
+*                   buffer runs low, so most RIOs don't reach the OS at all.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void InputFill(void)
+{
+    unsigned int tail = inputTail & (INPUT_RING - 1);
+    unsigned int space = INPUT_RING - (inputTail - inputHead);
+    long n;
+
+    if (!inputOpen || inputEOF)
+        return;
+    if (space > INPUT_RING - tail)
+        space = INPUT_RING - tail; // up to the end of the ring, the rest next time
+    if (replayFile != NULL)
+    {
+        ReplayFill(&inputRing[tail], space);
+        return;
+    }
+#ifdef _WIN32
+    n = (long)fread(&inputRing[tail], 1, space, inputFile);
+    if (n == 0)
+        inputEOF = true;
+#else
+    n = (long)read(inputFd, &inputRing[tail], space);
+    if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+        inputWaiting = false; // a writer is connected, from now on 0 is the end
+    else if (n == 0 && inputWaiting)
+        return; // no writer yet, no data yet
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        inputEOF = true; // end of file, writer closed the FIFO, or a read error
+#endif
+    if (n > 0)
+        inputTail += (unsigned int)n;
+    if (recordFile != NULL && (n > 0 || inputEOF))
+        RecordChunk(&inputRing[tail], n > 0 ? (unsigned long long)n : 0);
+}
+
+/*===============================================
+*   FUNCTION    :   RecordOpen / ReplayOpen
+*   DESCRIPTION :   Creates an input log, or opens one and attaches it to the
+*                   input device in place of a stream.
+*   ARGUMENTS   :   const char *path
+*   RETURNS     :   INT (1 if the log was opened, 0 otherwise)
+ *==============================================*/
+int RecordOpen(const char *path)
+{
+    recordFile = fopen(path, "wb");
+    if (recordFile == NULL)
+    {
+        printf("Error: cannot create input log %s\n", path);
+        return 0;
+    }
+    fputs(LOG_MAGIC, recordFile);
+    fputc(LOG_VERSION, recordFile);
+    return 1;
+}
+
+int ReplayOpen(const char *path)
+{
+    char magic[sizeof(LOG_MAGIC)];
+
+    replayFile = fopen(path, "rb");
+    if (replayFile == NULL)
+    {
+        printf("Error: cannot open input log %s\n", path);
+        return 0;
+    }
+    if (fread(magic, 1, sizeof(LOG_MAGIC), replayFile) != sizeof(LOG_MAGIC)
+        || memcmp(magic, LOG_MAGIC, sizeof(LOG_MAGIC) - 1) != 0 || magic[sizeof(LOG_MAGIC) - 1] != LOG_VERSION)
+    {
+        printf("Error: %s is not an input log\n", path);
+        fclose(replayFile);
+        replayFile = NULL;
+        return 0;
+    }
+    inputOpen = true;
+    inputEOF = false;
+    return 1;
+}
+
+/*===============================================
+*   FUNCTION    :   RecordChunk
+*   DESCRIPTION :   Appends a chunk read from the stream at the current cycle
+*                   to the input log, length 0 for the end of input.
+*   ARGUMENTS   :   const unsigned char *data, unsigned long long length
+*   RETURNS     :   VOID
+ *==============================================*/
+void RecordChunk(const unsigned char *data, unsigned long long length)
+{
+    writeVarint(recordFile, cycleCount - logCycle);
+    writeVarint(recordFile, length);
+    fwrite(data, 1, (size_t)length, recordFile);
+    logCycle = cycleCount;
+}
+
+/*===============================================
+*   FUNCTION    :   ReplayFill
+*   DESCRIPTION :   InputFill() of a replayed run: delivers the next chunk of
+*                   the log once its cycle is reached. A run of the recorded
+*                   program asks at the same cycles as the recording did, so
+*                   each call gets the chunk one read() got. A chunk larger
+*                   than the free space (the program changed) is split.
+*   ARGUMENTS   :   unsigned char *data (tail of the ring), unsigned int space
+*   RETURNS     :   VOID
+ *==============================================*/
+void ReplayFill(unsigned char *data, unsigned int space)
+{
+    unsigned long long delta;
+    size_t n;
+
+    if (!replayPending)
+    {
+        if (!readVarint(replayFile, &delta) || !readVarint(replayFile, &replayLeft))
+            return; // end of the log, the stream stays open but quiet
+        replayCycle = logCycle + delta;
+        logCycle = replayCycle;
+        replayPending = true;
+    }
+    if (replayCycle > cycleCount)
+        return;
+    if (replayLeft == 0)
+    {
+        inputEOF = true;
+        replayPending = false;
+        return;
+    }
+    n = fread(data, 1, (size_t)(replayLeft < space ? replayLeft : space), replayFile);
+    inputTail += (unsigned int)n;
+    replayLeft -= n;
+    if (replayLeft == 0 || n == 0)
+        replayPending = false; // a truncated log ends like the end of the log
+}
+
+/*===============================================
+*   FUNCTION    :   writeVarint / readVarint
+*   DESCRIPTION :   LEB128 integers of the input log, 7 bits per byte, low
+*                   bits first, bit 7 set on all bytes but the last.
+*   ARGUMENTS   :   FILE *file, unsigned long long value / *value
+*   RETURNS     :   VOID / BOOL (false at the end of the file)
+ *==============================================*/
+void writeVarint(FILE *file, unsigned long long value)
+{
+    while(value >= 0x80)
+    {
+        fputc((int)(value & 0x7F) | 0x80, file);
+        value >>= 7;
+    }
+    fputc((int)value, file);
+}
+
+bool readVarint(FILE *file, unsigned long long *value)
+{
+    int byte, shift = 0;
+
+    *value = 0;
+    do
+    {
+        if((byte = fgetc(file)) == EOF || shift > 63)
+            return false;
+        *value |= (unsigned long long)(byte & 0x7F) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+    return true;
+}
+
+/*===============================================
+*   FUNCTION    :   InputSim
+*   DESCRIPTION :   Input device at 0x010 - 0x01F of IO Memory. A read of
+*                   INPUT_DATA takes the next byte out of the ring buffer,
+*                   INPUT_STATUS and INPUT_COUNT tell the program whether
+*                   there is a byte to read or the stream has ended. Without
+*                   an attached stream the input reports end of input.
+*   ARGUMENTS   :   VOID (ADDR holds the address being read)
+*   RETURNS     :   VOID
+ *==============================================*/
+void InputSim(void)
+{
+    unsigned int count = inputTail - inputHead;
+
+    if (count < INPUT_RING / 4)
+    {
+        InputFill();
+        count = inputTail - inputHead;
+    }
+    if (ADDR == INPUT_DATA)
+    {
+        iOData[INPUT_DATA] = 0x00;
+        if (count > 0)
+        {
+            iOData[INPUT_DATA] = inputRing[inputHead++ & (INPUT_RING - 1)];
+            count--;
+        }
+    }
+    iOData[INPUT_STATUS] = (count > 0 ? INPUT_AVAILABLE : 0) | (count == 0 && (!inputOpen || inputEOF) ? INPUT_END : 0);
+    iOData[INPUT_COUNT] = count > 0xFF ? 0xFF : (unsigned char)count;
+    inputLine();
+}
+
+/*===============================================
+*   FUNCTION    :   InputSimRead
+*   DESCRIPTION :   Read callback of the input stream device.
+*   ARGUMENTS   :   UNSIGNED INT offset (from INPUT_DATA)
+*   RETURNS     :   UNSIGNED CHAR
+ *==============================================*/
+unsigned char InputSimRead(unsigned int offset)
+{
+    InputSim(); // input device updates its registers
+    return iOData[INPUT_DATA + offset];
+}
+
+
+/*===============================================
+*   FUNCTION    :   ALU
+*   DESCRIPTION :   ALU FUNCTION, coreALU() of CORE/Core.h on ACC, BUS and
+*                   FLAGS with the traced Booth's algorithm.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   INT
+ *==============================================*/
+int ALU(void)
+{
+    trace("\n");
+    coreALU(CONTROL, &ACC, &BUS, &FLAGS, boothsAlogrithm);
+
+    // printf("\nACC = "); printBin(ACC, 16);
+    if(CONTROL == subtraction)
+        trace("\n SUBTRACTION <--- ALU\n");
+    else if(CONTROL == addition)
+        trace("\nADDITION <--- ALU\n");
+    else if(CONTROL == multiplication) // Implementing Booths algorithm
+        trace("\nMULTIPLICATION <--- ALU\n");
+    else if(CONTROL == AND || CONTROL == OR || CONTROL == NOT || CONTROL == XOR || CONTROL == shift_left
+            || CONTROL == shift_right || CONTROL == WACC || CONTROL == RACC)
+    {
+        trace("\nACC = "); printBin(ACC, 16);
+        trace("\n%s <--- ALU\n", CONTROL == AND ? "AND" : CONTROL == OR ? "OR" : CONTROL == NOT ? "NOT"
+              : CONTROL == XOR ? "XOR" : CONTROL == shift_left ? "SHIFT LEFT" : CONTROL == shift_right ? "SHIFT RIGHT"
+              : CONTROL == WACC ? "WACC" : "RACC");
+    }
+    else
+    {
+        trace("\nInvalid Control Signal");
+        // Printing the control signal
+        trace("\nControl Signal: ");
+        printBin(CONTROL, 8);
+        if (!quiet)
+            getchar();
+    }
+    trace("\nACC = "); printBin(ACC, 16);
+    trace("\n");
+    return 0;
+}
+
+/*===============================================
+*   FUNCTION    :   boothsAlogrithm
+*   DESCRIPTION :   Performs multiplication using Booth's algorithm, the steps
+*                   of coreBoothStep() with a row of the table after each.
+*   ARGUMENTS   :   UNSIGNED CHAR M (multiplicand), UNSIGNED CHAR Q (multiplier)
+*   RETURNS     :   UNSIGNED INT (16-bit product)
+ *==============================================*/
+unsigned int boothsAlogrithm(unsigned char M, unsigned char Q) {  // Q Multiplier and M Multiplicand
+    int n;
+    unsigned char Q_N1 = 0;
+    unsigned char A = 0x00;
+    trace("\nA\t\t\tQ\t\t\tQn-1\tM\t    Cycle\n");
+    for(n = 0; n < 8; n++){
+        displayStep(A, Q, Q_N1, M, n);
+        coreBoothStep(&A, &Q, &Q_N1, M);
+    }
+    displayStep(A, Q, Q_N1, M, 8);
+    // Lastly we merge A and Q to get the result and then print the binary of 16 bits
+    unsigned int result = (A << 8) | Q;
+    trace("ACC = ");
+    printBin(result, 16);
+    return result;
+}
+
+/*===============================================
+*   FUNCTION    :   displayStep
+*   DESCRIPTION :   Displays the current state of the registers
+*   ARGUMENTS   :   UNSIGNED CHAR, UNSIGNED CHAR, UNSIGNED CHAR, UNSIGNED CHAR, INT
+*   RETURNS     :   VOID
+ *==============================================*/
+void displayStep(unsigned char A, unsigned char Q, unsigned char Q_N1, unsigned char M, int n)
+{
+    if (quiet)
+        return;
+    printBin(A, 8);
+    printf("\t");
+    printBin(Q, 8);
+    printf("\t");
+    printBin(Q_N1, 1);
+    printf("\t");
+    printBin(M, 8);
+    printf("\t");
+    printf("%d", n);
+    printf("\n");
+}
+
+/*===============================================
+*   FUNCTION    :   printBin
 *   DESCRIPTION :   Prints the binary representation of a number
 *   ARGUMENTS   :   INT, UNSIGNED CHAR
 *   RETURNS     :   VOID
  *==============================================*/
 void printBin(int data, unsigned char data_width)
 {
+    if (quiet)
+        return;
     for(int i = data_width-1; i >= 0; i--)
     {
         printf("%d", (data >> i) & 0x01);
@@ -1149,111 +2692,79 @@ void printBin(int data, unsigned char data_width)
 
 /*===============================================
 *  FUNCTION    :   SevenSegment
-*  DESCRIPTION :   Displays the seven segment display
+*  DESCRIPTION :   Displays the seven segment display. The digit in iOData[0x000]
+*                  is rendered into segmentFrame when it changes and written to
+*                  the terminal in one call, at most segmentFPS times a second
+*                  of wall-clock time. Values other than 0-9 leave the display as is.
 *  ARGUMENTS   :   VOID
 *  RETURNS     :   VOID
  *==============================================*/
 void SevenSegment()
 {
-    if(iOData[0x000]==0x01)
-    {
-        printf("    X\n");
-        printf("    X\n");
-        printf("    X\n");
-        printf("    X\n");
-        printf("    X\n");
-        printf("    X\n");
-        printf("    X\n");
-    }
-    else if(iOData[0x000]==0x02)
-    {
-        printf(" XXXXX\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf(" XXXXX\n");
-        printf(" X    \n");
-        printf(" X    \n");
-        printf(" XXXXX\n");
-    }
-    else if(iOData[0x000]==0x03)
-    {
-        printf(" XXXXX\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf(" XXXXX\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf(" XXXXX\n");
-    }
-    else if(iOData[0x000]==0x04)
+    static const char *glyphs[10][SEGMENT_ROWS] = {
+        {" XXXXX", " X   X", " X   X", " X   X", " X   X", " X   X", " XXXXX"},
+        {"    X", "    X", "    X", "    X", "    X", "    X", "    X"},
+        {" XXXXX", "     X", "     X", " XXXXX", " X    ", " X    ", " XXXXX"},
+        {" XXXXX", "     X", "     X", " XXXXX", "     X", "     X", " XXXXX"},
+        {" X   X", " X   X", " X   X", " XXXXX", "     X", "     X", "     X"},
+        {" XXXXX", " X    ", " X    ", " XXXXX", "     X", "     X", " XXXXX"},
+        {" XXXXX", " X    ", " X    ", " XXXXX", " X   X", " X   X", " XXXXX"},
+        {" XXXXX", "     X", "     X", "     X", "     X", "     X", "     X"},
+        {" XXXXX", " X   X", " X   X", " XXXXX", " X   X", " X   X", " XXXXX"},
+        {" XXXXX", " X   X", " X   X", " XXXXX", "     X", "     X", " XXXXX"}
+    };
+    int digit = iOData[0x000], row;
+    char *p = segmentFrame;
+
+    if(!segmentEnabled || digit > 9)
+        return;
+    if(digit != (segmentPending >= 0 ? segmentPending : segmentShown))
     {
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" XXXXX\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf("     X\n");
-    }
-    else if(iOData[0x000]==0x05)
-    {
-        printf(" XXXXX\n");
-        printf(" X    \n");
-        printf(" X    \n");
-        printf(" XXXXX\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf(" XXXXX\n");
-    }
-    else if(iOData[0x000]==0x06)
-    {
-        printf(" XXXXX\n");
-        printf(" X    \n");
-        printf(" X    \n");
-        printf(" XXXXX\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" XXXXX\n");
-    }
-    else if(iOData[0x000]==0x07)
-    {
-        printf(" XXXXX\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf("     X\n");
-    }
-    else if(iOData[0x000]==0x08)
-    {
-        printf(" XXXXX\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" XXXXX\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" XXXXX\n");
-    }
-    else if(iOData[0x000]==0x09)
-    {
-        printf(" XXXXX\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" XXXXX\n");
-        printf("     X\n");
-        printf("     X\n");
-        printf(" XXXXX\n");
+        for(row = 0; row < SEGMENT_ROWS; row++)
+        {
+            strcpy(p, glyphs[digit][row]);
+            p += strlen(p);
+            *p++ = '\n';
+        }
+        *p = '\0';
+        segmentPending = digit;
     }
-    else if(iOData[0x000]==0x00)
+    SevenSegmentFlush(false);
+}
+
+/*===============================================
+*  FUNCTION    :   SevenSegmentWrite
+*  DESCRIPTION :   Write callback of the seven segment display.
+*  ARGUMENTS   :   UNSIGNED INT offset, UNSIGNED CHAR data
+*  RETURNS     :   VOID
+ *==============================================*/
+void SevenSegmentWrite(unsigned int offset, unsigned char data)
+{
+    iOData[0x000 + offset] = data;
+    SevenSegment();
+}
+
+/*===============================================
+*  FUNCTION    :   SevenSegmentFlush
+*  DESCRIPTION :   Writes a pending frame to the terminal, unless the last
+*                  redraw was less than 1/segmentFPS seconds ago.
+*  ARGUMENTS   :   bool force (ignore the FPS limit, used when the run ends)
+*  RETURNS     :   VOID
+ *==============================================*/
+void SevenSegmentFlush(bool force)
+{
+    double now;
+
+    if(segmentPending < 0 || segmentPending == segmentShown)
     {
-        printf(" XXXXX\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" X   X\n");
-        printf(" XXXXX\n");
+        segmentPending = -1;
+        return;
     }
-   // getc(stdin);
-}
\ No newline at end of file
+    now = wallClock();
+    if(!force && segmentFPS > 0 && segmentShown >= 0 && now - segmentLastFlush < 1 / segmentFPS)
+        return;
+    fputs(segmentFrame, stdout);
+    segmentShown = segmentPending;
+    segmentPending = -1;
+    segmentLastFlush = now;
+}
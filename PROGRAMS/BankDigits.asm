@@ -0,0 +1,39 @@
+; BankDigits.asm
+; Stores a digit at the same address (0x400) in banks 1 - 3, then shows them
+; from bank 3 down to bank 1. Each bank is a separate 1 KB behind 0x400 - 0x7FF.
+
+SEGMENT         EQU 0x000       ; output latch of the seven segment display
+BANK_SELECT     EQU 0x031       ; bank shown at 0x400 - 0x7FF
+CELL            EQU 0x400
+
+        WIB     1
+        WIO     BANK_SELECT
+        WB      7
+        WM      CELL            ; bank 1: 7
+        WIB     2
+        WIO     BANK_SELECT
+        WB      8
+        WM      CELL            ; bank 2: 8
+        WIB     3
+        WIO     BANK_SELECT
+        WB      9
+        WM      CELL            ; bank 3: 9
+        RM      CELL            ; bank 3
+        SWAP
+        WIO     SEGMENT
+        WIB     2
+        WIO     BANK_SELECT
+        RM      CELL            ; bank 2
+        SWAP
+        WIO     SEGMENT
+        WIB     1
+        WIO     BANK_SELECT
+        RM      CELL            ; bank 1
+        SWAP
+        WIO     SEGMENT
+        WIB     0
+        WIO     BANK_SELECT
+        RM      CELL            ; bank 0 was never written
+        SWAP
+        WIO     SEGMENT
+        EOP
@@ -0,0 +1,78 @@
+; BenchBranch.asm
+; Benchmark: sorts every byte i into below (i - 0x40 is negative as a signed
+; byte), odd or even with BRLT, BRNE and BRE whose outcomes change with i,
+; 512 times (about 2.8 million instructions). Shows the last even count.
+; Run with LE6 -q -n BenchBranch.bin
+
+SEGMENT EQU 0x000               ; output latch of the seven segment display
+
+pass:   WB      0
+        WM      evens
+        WM      odds
+        WM      belows
+sort:   RM      i
+        WACC
+        WB      0x40
+        BRLT    below           ; i - 0x40 (compares destroy ACC)
+        RM      i
+        WACC
+        WB      1
+        AND                     ; ACC <- i & 1
+        WB      0
+        BRE     even
+        RM      odds
+        WACC
+        WB      1
+        ADD
+        RACC
+        WM      odds
+        BR      next
+even:   RM      evens
+        WACC
+        WB      1
+        ADD
+        RACC
+        WM      evens
+        BR      next
+below:  RM      belows
+        WACC
+        WB      1
+        ADD
+        RACC
+        WM      belows
+next:   RM      i               ; i <- i - 1, 0 then 255 down to 1
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      i
+        WB      0
+        BRNE    sort
+        RM      lo              ; 256 passes for every count of hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      lo
+        WB      0
+        BRNE    pass
+        RM      hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      hi
+        WB      0
+        BRNE    pass
+
+        RM      evens
+        SWAP
+        WIO     SEGMENT         ; 64: i from 0x40 to 0xBF, half of them even
+        EOP
+
+i:      DB      0
+evens:  DB      0
+odds:   DB      0
+belows: DB      0
+lo:     DB      0
+hi:     DB      2
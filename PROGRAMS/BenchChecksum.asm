@@ -0,0 +1,53 @@
+; BenchChecksum.asm
+; Benchmark: adds up the first 256 bytes of main memory (this program and its
+; variables) modulo 256, 512 times (about 2.1 million instructions), and shows
+; the last sum. The loop writes its index into the operand of the RM that
+; reads a byte. Run with LE6 -q -n BenchChecksum.bin
+
+SEGMENT EQU 0x000               ; output latch of the seven segment display
+DATA    EQU 0x000
+
+pass:   WB      0
+        WM      sum
+byte:   RM      i
+        WM      get+1           ; low byte of the operand
+        RM      sum
+        WACC                    ; ACC <- sum
+get:    RM      DATA            ; MBR <- DATA[i]
+        ADD
+        RACC
+        WM      sum
+        RM      i               ; i <- i - 1, 0 then 255 down to 1
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      i
+        WB      0
+        BRNE    byte
+        RM      lo              ; 256 passes for every count of hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      lo
+        WB      0
+        BRNE    pass
+        RM      hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      hi
+        WB      0
+        BRNE    pass
+
+        RM      sum
+        SWAP
+        WIO     SEGMENT
+        EOP
+
+i:      DB      0
+sum:    DB      0
+lo:     DB      0
+hi:     DB      2
@@ -0,0 +1,35 @@
+; BenchCountdown.asm
+; Benchmark: counts down 255..1 on the seven segment display, 1024 times
+; (about 1.8 million instructions). Run with LE6 -q -n BenchCountdown.bin
+
+SEGMENT EQU 0x000               ; output latch of the seven segment display
+
+pass:   WB      0xFF
+        WACC                    ; ACC <- 255
+tick:   RACC
+        SWAP                    ; IOBR <- count
+        WIO     SEGMENT
+        WB      1
+        SUB                     ; ACC <- count - 1
+        WB      0
+        BRNE    tick
+        RM      lo              ; 256 passes for every count of hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      lo
+        WB      0
+        BRNE    pass
+        RM      hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      hi
+        WB      0
+        BRNE    pass
+        EOP
+
+lo:     DB      0
+hi:     DB      4
@@ -0,0 +1,55 @@
+; BenchMemCopy.asm
+; Benchmark: copies the 256 bytes at 0x400 to 0x500, 1024 times (about 2.4
+; million instructions), then shows the byte copied to 0x505. There is no
+; indexed addressing, so the loop writes its index into the operands of the
+; RM and WM that move a byte. Run with LE6 -q -n BenchMemCopy.bin
+
+SEGMENT EQU 0x000               ; output latch of the seven segment display
+SRC     EQU 0x400               ; group B, 256 bytes
+DST     EQU 0x500
+
+        WB      0
+        WACC                    ; i <- 0, then 255 down to 1
+fill:   RACC
+        WM      put+1           ; low byte of the operand
+put:    WM      SRC             ; SRC[i] <- i
+        WB      1
+        SUB
+        WB      0
+        BRNE    fill
+
+pass:   WB      0
+        WACC
+copy:   RACC
+        WM      get+1
+        WM      set+1
+get:    RM      SRC
+set:    WM      DST             ; DST[i] <- SRC[i]
+        WB      1
+        SUB
+        WB      0
+        BRNE    copy
+        RM      lo              ; 256 passes for every count of hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      lo
+        WB      0
+        BRNE    pass
+        RM      hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      hi
+        WB      0
+        BRNE    pass
+
+        RM      DST+5
+        SWAP
+        WIO     SEGMENT         ; shows 5
+        EOP
+
+lo:     DB      0
+hi:     DB      4
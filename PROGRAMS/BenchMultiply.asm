@@ -0,0 +1,63 @@
+; BenchMultiply.asm
+; Benchmark: multiplies every byte a by itself eight times with MUL (Booth's
+; algorithm in the ALU) and adds the low bytes up modulo 256, 256 times
+; (about 1.7 million instructions). Shows the sum of the last pass.
+; Run with LE6 -q -n BenchMultiply.bin
+
+SEGMENT EQU 0x000               ; output latch of the seven segment display
+
+pass:   WB      0
+        WM      chk
+power:  RM      a
+        WACC                    ; ACC <- a, MBR = a
+        MUL
+        MUL
+        MUL
+        MUL
+        MUL
+        MUL
+        MUL
+        MUL                     ; ACC <- a^9, as the ALU's Booth steps compute it
+        RACC
+        WM      prod
+        RM      chk
+        WACC
+        RM      prod
+        ADD
+        RACC
+        WM      chk             ; chk <- chk + low byte
+        RM      a               ; a <- a - 1, 0 then 255 down to 1
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      a
+        WB      0
+        BRNE    power
+        RM      lo              ; 256 passes for every count of hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      lo
+        WB      0
+        BRNE    pass
+        RM      hi
+        WACC
+        WB      1
+        SUB
+        RACC
+        WM      hi
+        WB      0
+        BRNE    pass
+
+        RM      chk
+        SWAP
+        WIO     SEGMENT
+        EOP
+
+a:      DB      0
+prod:   DB      0
+chk:    DB      0
+lo:     DB      0
+hi:     DB      1
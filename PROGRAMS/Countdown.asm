@@ -0,0 +1,28 @@
+; Countdown.asm
+; Counts down 9..0 on the seven segment display latched at IO address 0x000.
+; Same program as the initMemory() listing of LE6.
+
+SEGMENT EQU 0x000               ; output latch of the seven segment display
+
+        WB      2
+        WIB     9
+        WIO     SEGMENT
+        WIB     8
+        WIO     SEGMENT
+        WIB     7
+        WIO     SEGMENT
+        WIB     6
+        WIO     SEGMENT
+        WIB     5
+        WIO     SEGMENT
+        WIB     4
+        WIO     SEGMENT
+        WIB     3
+        WIO     SEGMENT
+        WIB     2
+        WIO     SEGMENT
+        WIB     1
+        WIO     SEGMENT
+        WIB     0
+        WIO     SEGMENT
+        EOP
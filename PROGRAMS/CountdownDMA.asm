@@ -0,0 +1,38 @@
+; CountdownDMA.asm
+; Countdown.asm with the digits sent by the DMA engine: ten bytes from main
+; memory to the seven segment latch, while the CU only waits for the end.
+
+SEGMENT     EQU 0x000           ; output latch of the seven segment display
+DMA_IO_LO   EQU 0x024           ; IO address, bits 7 - 0
+DMA_IO_HI   EQU 0x025           ; IO address, bits 10 - 8
+DMA_MEM_LO  EQU 0x026           ; main memory address, bits 7 - 0
+DMA_MEM_HI  EQU 0x027           ; main memory address, bits 10 - 8
+DMA_COUNT   EQU 0x028           ; bytes to move
+DMA_CONTROL EQU 0x029           ; start and mode, bit 7 busy
+DMA_START   EQU 0x01
+DMA_TO_IO   EQU 0x02
+DMA_FIXED   EQU 0x04
+DMA_BUSY    EQU 0x80
+
+        WIB     SEGMENT
+        WIO     DMA_IO_LO
+        WIB     0
+        WIO     DMA_IO_HI
+        WIB     digits & 0xFF
+        WIO     DMA_MEM_LO
+        WIB     digits >> 8
+        WIO     DMA_MEM_HI
+        WIB     10
+        WIO     DMA_COUNT
+        WIB     DMA_START | DMA_TO_IO | DMA_FIXED
+        WIO     DMA_CONTROL
+wait:   RIO     DMA_CONTROL
+        SWAP
+        WACC
+        WB      DMA_BUSY
+        AND
+        WB      0
+        BRNE    wait
+        EOP
+
+digits: DB      9, 8, 7, 6, 5, 4, 3, 2, 1, 0
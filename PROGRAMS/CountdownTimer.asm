@@ -0,0 +1,63 @@
+; CountdownTimer.asm
+; Countdown.asm paced by the timer: one digit every 100000 cycles. The wait
+; loop only polls the status, so LE6 fast-forwards it to the next expiry.
+; It first runs a one-tick period out and reads the count, which has to be 0
+; (the program ends without counting down otherwise).
+
+SEGMENT         EQU 0x000       ; output latch of the seven segment display
+TIMER_RELOAD_LO EQU 0x02A       ; ticks per period
+TIMER_RELOAD_HI EQU 0x02B
+TIMER_PRESCALER EQU 0x02C       ; cycles per tick minus one
+TIMER_CONTROL   EQU 0x02D
+TIMER_STATUS    EQU 0x02E       ; bit 0 expired, write 1 to clear
+TIMER_COUNT_LO  EQU 0x02F       ; ticks left in the period
+TIMER_ENABLE    EQU 0x01
+TIMER_PERIODIC  EQU 0x02
+PERIOD          EQU 1000        ; ticks of 100 cycles
+
+        WIB     1
+        WIO     TIMER_RELOAD_LO
+        WIB     0
+        WIO     TIMER_RELOAD_HI
+        WIO     TIMER_PRESCALER
+        WIB     TIMER_ENABLE    ; one shot of one cycle
+        WIO     TIMER_CONTROL
+        RIO     TIMER_COUNT_LO  ; expired while the instruction ran
+        SWAP
+        WACC
+        WB      0
+        BRNE    done            ; ACC <- count - 0
+        WIB     1
+        WIO     TIMER_STATUS    ; acknowledge the one shot
+        WIB     PERIOD & 0xFF
+        WIO     TIMER_RELOAD_LO
+        WIB     PERIOD >> 8
+        WIO     TIMER_RELOAD_HI
+        WIB     99
+        WIO     TIMER_PRESCALER
+        WIB     TIMER_ENABLE | TIMER_PERIODIC
+        WIO     TIMER_CONTROL
+show:   RM      count
+        SWAP                    ; IOBR <- count
+        WIO     SEGMENT
+wait:   RIO     TIMER_STATUS
+        SWAP
+        WACC
+        WB      1
+        AND
+        WB      0
+        BRE     wait            ; until the timer expires
+        WIB     1
+        WIO     TIMER_STATUS    ; acknowledge
+        RM      count
+        WACC
+        WB      0
+        BRE     done            ; ACC <- count - 0
+        WB      1
+        SUB
+        RACC
+        WM      count           ; count <- count - 1
+        BR      show
+done:   EOP
+
+count:  DB      9
@@ -0,0 +1,32 @@
+; InputDigits.asm
+; Shows every ASCII digit read from the input stream on the seven segment display,
+; until the end of input. Run with LE6 -q -r digits.txt InputDigits.bin
+
+SEGMENT EQU 0x000               ; output latch of the seven segment display
+DATA    EQU 0x010               ; next input byte, reading it consumes the byte
+STATUS  EQU 0x011               ; bit 0 byte available, bit 1 end of input
+
+wait:   RIO     STATUS
+        SWAP                    ; MBR <- status
+        WACC
+        WB      2
+        AND                     ; ACC <- status & end of input
+        WB      0
+        BRNE    done
+        RIO     STATUS
+        SWAP
+        WACC
+        WB      1
+        AND                     ; ACC <- status & byte available
+        WB      0
+        BRE     wait
+        RIO     DATA
+        SWAP
+        WACC                    ; ACC <- input byte
+        WB      '0'
+        SUB
+        RACC
+        SWAP                    ; IOBR <- digit
+        WIO     SEGMENT
+        BR      wait
+done:   EOP
@@ -0,0 +1,38 @@
+; InputInterrupt.asm
+; InputDigits.asm driven by the input interrupt: the main loop waits on a
+; flag while the handler shows every digit that arrives on the display.
+; Run with LE6 -q -r digits.txt InputInterrupt.bin
+
+SEGMENT   EQU 0x000             ; output latch of the seven segment display
+DATA      EQU 0x010             ; next input byte, reading it consumes the byte
+STATUS    EQU 0x011             ; bit 0 byte available, bit 1 end of input
+IRQ_MASK  EQU 0x021             ; enabled interrupt lines
+VECTOR_LO EQU 0x022             ; handler address, bits 7 - 0
+VECTOR_HI EQU 0x023             ; handler address, bits 10 - 8
+IRQ_INPUT EQU 0x01              ; input stream has a byte
+
+        WIB     handler & 0xFF
+        WIO     VECTOR_LO
+        WIB     handler >> 8
+        WIO     VECTOR_HI
+        WIB     IRQ_INPUT
+        WIO     IRQ_MASK
+wait:   RIO     STATUS          ; interrupts come in between instructions
+        SWAP
+        WACC
+        WB      2
+        AND
+        WB      0
+        BRE     wait            ; until the end of input
+        EOP
+
+handler:
+        RIO     DATA
+        SWAP
+        WACC                    ; ACC <- input byte
+        WB      '0'
+        SUB
+        RACC
+        SWAP                    ; IOBR <- digit
+        WIO     SEGMENT
+        RETI
@@ -0,0 +1,39 @@
+; UartLoopback.asm
+; Sends the digits 3, 2, 1, 0 through the byte pipe and shows each one on the
+; seven segment display as it comes back, then keeps the cycles it took from
+; the free-running counter in elapsed.
+
+SEGMENT     EQU 0x000           ; output latch of the seven segment display
+COUNTER_LO  EQU 0x032           ; cycles since cleared, reading it latches the upper byte
+UART_DATA   EQU 0x034           ; write: send, read: the oldest received byte
+UART_STATUS EQU 0x035           ; bit 0 a byte was received, bit 1 the queue is full
+RECEIVED    EQU 0x01
+
+        WIO     COUNTER_LO      ; clear the count
+        WIB     3
+        WIO     UART_DATA
+        WIB     2
+        WIO     UART_DATA
+        WIB     1
+        WIO     UART_DATA
+        WIB     0
+        WIO     UART_DATA
+wait:   RIO     UART_STATUS
+        SWAP
+        WACC
+        WB      RECEIVED
+        AND
+        WB      0
+        BRE     wait            ; until a byte is back
+        RIO     UART_DATA
+        WIO     SEGMENT
+        SWAP
+        WACC
+        WB      0
+        BRNE    wait            ; up to the 0
+        RIO     COUNTER_LO
+        SWAP
+        WM      elapsed
+        EOP
+
+elapsed: DB     0
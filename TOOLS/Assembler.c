@@ -0,0 +1,946 @@
+ /*======================================================================================================
+* FILE        : Assembler.c
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : Two-pass assembler for the CU instruction set. Turns mnemonic source into a memory
+*               image that the simulator loads instead of the hand-encoded initMemory() listing.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+*   19 October, 2026: V1.1 - RETI
+*   19 October, 2026: V1.2 - WB and WIB operands are range-checked to 8 bits like DB
+======================================================================================================*/
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define MEMORY_SIZE 2048        // 11-bit address space of the main memory
+#define OPERAND_MASK 0x07FF     // lower 11 bits of IR
+#define MAX_LINE 256
+#define MAX_NAME 32
+#define MAX_SYMBOLS 4096        // must be a power of two (hash table slots)
+
+// Operand kinds
+#define OPERAND_NONE 0          // implicit operation, operand bits unused
+#define OPERAND_ADDRESS 1       // memory, IO or branch address (0x000 - 0x7FF)
+#define OPERAND_DATA 2          // byte loaded to MBR/IOBR, -0x80 - 0xFF
+
+// Output formats
+#define FORMAT_BIN 0            // raw image, byte n is loaded at address n
+#define FORMAT_C 1              // initMemory() statements
+
+typedef struct
+{
+    const char *name;
+    unsigned char opcode;
+    unsigned char kind;
+} Mnemonic;
+
+typedef struct
+{
+    char name[MAX_NAME];
+    unsigned int hash;
+    unsigned int generation;    // slot is only valid for the file being assembled
+    int value;
+    int line;
+} Symbol;
+
+// Instruction set, same codes the CU decodes from IR>>11
+const Mnemonic mnemonics[] = {
+    {"WM", 0x01, OPERAND_ADDRESS},   {"RM", 0x02, OPERAND_ADDRESS},   {"BR", 0x03, OPERAND_ADDRESS},
+    {"RIO", 0x04, OPERAND_ADDRESS},  {"WIO", 0x05, OPERAND_ADDRESS},  {"WB", 0x06, OPERAND_DATA},
+    {"WIB", 0x07, OPERAND_DATA},     {"RETI", 0x08, OPERAND_NONE},    {"WACC", 0x09, OPERAND_NONE},
+    {"RACC", 0x0B, OPERAND_NONE},    {"SWAP", 0x0E, OPERAND_NONE},    {"BRLT", 0x11, OPERAND_ADDRESS},
+    {"BRGT", 0x12, OPERAND_ADDRESS}, {"BRNE", 0x13, OPERAND_ADDRESS}, {"BRE", 0x14, OPERAND_ADDRESS},
+    {"SHR", 0x15, OPERAND_NONE},     {"SHL", 0x16, OPERAND_NONE},     {"XOR", 0x17, OPERAND_NONE},
+    {"NOT", 0x18, OPERAND_NONE},     {"OR", 0x19, OPERAND_NONE},      {"AND", 0x1A, OPERAND_NONE},
+    {"MUL", 0x1B, OPERAND_NONE},     {"SUB", 0x1D, OPERAND_NONE},     {"ADD", 0x1E, OPERAND_NONE},
+    {"EOP", 0x1F, OPERAND_NONE}
+};
+#define MNEMONIC_COUNT (sizeof(mnemonics) / sizeof(mnemonics[0]))
+
+// Symbol table
+Symbol symbols[MAX_SYMBOLS];
+unsigned int generation = 0;
+int symbolCount = 0;
+
+// Assembler state (reset for every source file)
+const char *fileName;
+int lineNumber;
+int pass;
+int location;                   // address of the next byte to be emitted
+int errorCount;
+bool unresolved;                // expression referenced a symbol not yet defined
+unsigned char image[MEMORY_SIZE];
+unsigned char used[MEMORY_SIZE / 8];
+int imageSize;                  // highest address written + 1
+
+// Options
+int format = FORMAT_BIN;
+bool listing = false;
+
+/*===============================================
+ *   FUNCTION PROTOTYPES
+ *==============================================*/
+int assemble(const char *source, size_t length);
+void assembleLine(char *line);
+void emit(int value);
+void error(const char *fmt, ...);
+
+// Expression prototypes
+int parseExpression(const char **p);
+int parseBinary(const char **p, int level);
+int parseUnary(const char **p);
+int parsePrimary(const char **p);
+
+// Symbol prototypes
+Symbol *lookupSymbol(const char *name, bool create);
+void defineSymbol(const char *name, int value);
+
+// Lexer prototypes
+void skipSpace(const char **p);
+bool atEnd(const char **p);
+int readName(const char **p, char *name);
+const Mnemonic *findMnemonic(const char *name);
+bool isDirective(const char *name, const char *directive);
+
+// File prototypes
+char *readSource(FILE *fp, size_t *length);
+bool writeImage(const char *path);
+char *outputPath(const char *input);
+char *copyString(const char *text);
+
+/*===============================================
+*   FUNCTION    :   MAIN
+*   DESCRIPTION :   Assembles every source file given on the command line.
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 if every file assembled, 1 otherwise)
+ *==============================================*/
+int main(int argc, char *argv[])
+{
+    const char *output = NULL;
+    char *source, *path;
+    size_t length;
+    FILE *fp;
+    int i, inputs = 0, failed = 0;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "bin") == 0)
+                format = FORMAT_BIN;
+            else if(strcmp(argv[i], "c") == 0)
+                format = FORMAT_C;
+            else
+            {
+                fprintf(stderr, "Unknown output format '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-l") == 0)
+            listing = true;
+        else if(argv[i][0] == '-' && argv[i][1] != '\0')
+        {
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+        else
+            inputs++;
+    }
+
+    if(inputs == 0)
+    {
+        fprintf(stderr, "Usage: %s [-f bin|c] [-o output] [-l] source.asm ...\n", argv[0]);
+        fprintf(stderr, "       Use '-' to read the source from stdin and write the image to stdout.\n");
+        return 1;
+    }
+    if(output != NULL && inputs > 1)
+    {
+        fprintf(stderr, "-o can only be used with a single source file\n");
+        return 1;
+    }
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "-f") == 0)
+        {
+            i++; // skip the option value
+            continue;
+        }
+        if(argv[i][0] == '-' && argv[i][1] != '\0')
+            continue;
+
+        fileName = argv[i];
+        fp = strcmp(fileName, "-") == 0 ? stdin : fopen(fileName, "rb");
+        if(fp == NULL)
+        {
+            fprintf(stderr, "%s: cannot open file\n", fileName);
+            failed++;
+            continue;
+        }
+        source = readSource(fp, &length);
+        if(fp != stdin)
+            fclose(fp);
+        if(source == NULL)
+        {
+            fprintf(stderr, "%s: cannot read file\n", fileName);
+            failed++;
+            continue;
+        }
+
+        if(assemble(source, length) == 0)
+        {
+            if(output != NULL)
+                path = copyString(output);
+            else
+                path = outputPath(fileName);
+            if(path == NULL || !writeImage(path))
+                failed++;
+            free(path);
+        }
+        else
+            failed++;
+        free(source);
+    }
+    return failed ? 1 : 0;
+}
+
+/*===============================================
+*   FUNCTION    :   assemble
+*   DESCRIPTION :   Runs both passes over a source buffer. Pass 1 collects label
+*                   addresses, pass 2 encodes instructions into image[].
+*   ARGUMENTS   :   const char *source, size_t length
+*   RETURNS     :   INT (number of errors)
+ *==============================================*/
+int assemble(const char *source, size_t length)
+{
+    char line[MAX_LINE];
+    const char *p, *end, *eol;
+    size_t n;
+
+    generation++; // invalidates every symbol of the previous file in O(1)
+    symbolCount = 0;
+    errorCount = 0;
+    memset(image, 0, sizeof(image));
+    memset(used, 0, sizeof(used));
+    imageSize = 0;
+
+    for(pass = 1; pass <= 2 && errorCount == 0; pass++)
+    {
+        location = 0;
+        lineNumber = 0;
+        p = source;
+        end = source + length;
+        while(p < end)
+        {
+            eol = memchr(p, '\n', (size_t)(end - p));
+            if(eol == NULL)
+                eol = end;
+            n = (size_t)(eol - p);
+            if(n > 0 && p[n - 1] == '\r')
+                n--;
+            lineNumber++;
+            if(n >= MAX_LINE)
+                error("line is longer than %d characters", MAX_LINE - 1);
+            else
+            {
+                memcpy(line, p, n);
+                line[n] = '\0';
+                assembleLine(line);
+            }
+            p = eol + 1;
+        }
+    }
+    return errorCount;
+}
+
+/*===============================================
+*   FUNCTION    :   assembleLine
+*   DESCRIPTION :   Assembles one statement:
+*                       [label:] [mnemonic [operand]] [; comment]
+*                       [label:] ORG|DB|DW expression[, ...]
+*                       name EQU expression
+*   ARGUMENTS   :   char *line
+*   RETURNS     :   VOID
+ *==============================================*/
+void assembleLine(char *line)
+{
+    char name[MAX_NAME], next[MAX_NAME];
+    const char *p = line, *save;
+    const Mnemonic *m;
+    int start = location, value, i;
+
+    skipSpace(&p);
+    if(atEnd(&p))
+        goto done;
+
+    if(readName(&p, name) == 0)
+    {
+        error("expected a label, mnemonic or directive");
+        return;
+    }
+
+    // label definition
+    if(*p == ':')
+    {
+        p++;
+        if(pass == 1)
+            defineSymbol(name, location);
+        skipSpace(&p);
+        if(atEnd(&p))
+            goto done;
+        if(readName(&p, name) == 0)
+        {
+            error("expected a mnemonic or directive after the label");
+            return;
+        }
+    }
+
+    // constant definition: name EQU expression
+    save = p;
+    skipSpace(&p);
+    if(readName(&p, next) > 0 && isDirective(next, "EQU"))
+    {
+        unresolved = false;
+        value = parseExpression(&p);
+        if(pass == 1)
+        {
+            if(unresolved)
+                error("EQU expression for '%s' uses a symbol that is not defined yet", name);
+            else
+                defineSymbol(name, value);
+        }
+        goto trailing;
+    }
+    p = save;
+
+    if((m = findMnemonic(name)) != NULL)
+    {
+        value = 0;
+        skipSpace(&p);
+        if(m->kind != OPERAND_NONE)
+        {
+            if(atEnd(&p))
+            {
+                error("%s needs an operand", m->name);
+                return;
+            }
+            unresolved = false;
+            value = parseExpression(&p);
+            if(pass == 2)
+            {
+                if(m->kind == OPERAND_ADDRESS && (value < 0 || value > OPERAND_MASK))
+                    error("address 0x%x is outside 0x000 - 0x7FF", value);
+                else if(m->kind == OPERAND_DATA && (value < -0x80 || value > 0xFF))
+                    error("value %d does not fit the byte %s loads", value, m->name); // MBR/IOBR take 8 bits, like DB
+            }
+        }
+        else if(!atEnd(&p))
+        {
+            error("%s does not take an operand", m->name);
+            return;
+        }
+        value = (m->opcode << 11) | (value & OPERAND_MASK);
+        emit(value >> 8);   // upper byte first (big endian fetch)
+        emit(value & 0xFF);
+    }
+    else if(isDirective(name, "ORG"))
+    {
+        unresolved = false;
+        value = parseExpression(&p);
+        if(unresolved)
+            error("ORG address must be defined before it is used");
+        else if(value < 0 || value >= MEMORY_SIZE)
+            error("ORG address 0x%x is outside the main memory", value);
+        else
+            location = value;
+        start = location;
+    }
+    else if(isDirective(name, "DB") || isDirective(name, "DW"))
+    {
+        bool word = isDirective(name, "DW");
+        for(;;)
+        {
+            skipSpace(&p);
+            if(!word && *p == '"')
+            {
+                for(p++; *p != '"' && *p != '\0'; p++)
+                    emit((unsigned char)*p);
+                if(*p != '"')
+                {
+                    error("unterminated string");
+                    return;
+                }
+                p++;
+            }
+            else
+            {
+                unresolved = false;
+                value = parseExpression(&p);
+                if(word)
+                {
+                    if(pass == 2 && (value < -0x8000 || value > 0xFFFF))
+                        error("word value %d does not fit 16 bits", value);
+                    emit((value >> 8) & 0xFF);
+                    emit(value & 0xFF);
+                }
+                else
+                {
+                    if(pass == 2 && (value < -0x80 || value > 0xFF))
+                        error("byte value %d does not fit 8 bits", value);
+                    emit(value & 0xFF);
+                }
+            }
+            skipSpace(&p);
+            if(*p != ',')
+                break;
+            p++;
+        }
+    }
+    else
+    {
+        error("unknown mnemonic or directive '%s'", name);
+        return;
+    }
+
+trailing:
+    skipSpace(&p);
+    if(!atEnd(&p))
+        error("unexpected '%s'", p);
+
+done:
+    if(listing && pass == 2)
+    {
+        printf("0x%03x  ", start);
+        for(i = start; i < start + 4; i++)
+        {
+            if(i < location)
+                printf("%02x ", image[i]);
+            else
+                printf("   ");
+        }
+        printf(" %s\n", line);
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   emit
+*   DESCRIPTION :   Places one byte at the current location. Pass 1 only
+*                   advances the location counter.
+*   ARGUMENTS   :   int value
+*   RETURNS     :   VOID
+ *==============================================*/
+void emit(int value)
+{
+    if(location >= MEMORY_SIZE)
+    {
+        if(pass == 2 && location == MEMORY_SIZE)
+            error("program does not fit the %d byte main memory", MEMORY_SIZE);
+        location++;
+        return;
+    }
+    if(pass == 2)
+    {
+        if(used[location >> 3] & (1 << (location & 7)))
+            error("address 0x%03x is assembled twice", location);
+        used[location >> 3] |= (unsigned char)(1 << (location & 7));
+        image[location] = (unsigned char)value;
+        if(location + 1 > imageSize)
+            imageSize = location + 1;
+    }
+    location++;
+}
+
+/*===============================================
+*   FUNCTION    :   error
+*   DESCRIPTION :   Reports an error with the file and line number.
+*   ARGUMENTS   :   const char *fmt, ...
+*   RETURNS     :   VOID
+ *==============================================*/
+void error(const char *fmt, ...)
+{
+    va_list args;
+    fprintf(stderr, "%s:%d: error: ", fileName, lineNumber);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+    errorCount++;
+}
+
+/*===============================================
+*   FUNCTION    :   parseExpression
+*   DESCRIPTION :   Evaluates an expression. Operators follow C precedence:
+*                       |  ^  &  << >>  + -  * / %  unary - ~ +
+*                   Operands are numbers (123, 0x7B, 0b1111011, 'c'),
+*                   symbols, and $ for the address of the current statement.
+*   ARGUMENTS   :   const char **p
+*   RETURNS     :   INT
+ *==============================================*/
+int parseExpression(const char **p)
+{
+    return parseBinary(p, 0);
+}
+
+/*===============================================
+*   FUNCTION    :   parseBinary
+*   DESCRIPTION :   Precedence climbing for the binary operators, level 0
+*                   being the loosest (|) and level 5 the tightest (* / %).
+*   ARGUMENTS   :   const char **p, int level
+*   RETURNS     :   INT
+ *==============================================*/
+int parseBinary(const char **p, int level)
+{
+    int left, right;
+    char op;
+
+    if(level > 5)
+        return parseUnary(p);
+
+    left = parseBinary(p, level + 1);
+    for(;;)
+    {
+        skipSpace(p);
+        op = **p;
+        if(level == 0 && op == '|') (*p)++;
+        else if(level == 1 && op == '^') (*p)++;
+        else if(level == 2 && op == '&') (*p)++;
+        else if(level == 3 && (op == '<' || op == '>') && (*p)[1] == op) (*p) += 2;
+        else if(level == 4 && (op == '+' || op == '-')) (*p)++;
+        else if(level == 5 && (op == '*' || op == '/' || op == '%')) (*p)++;
+        else
+            return left;
+
+        right = parseBinary(p, level + 1);
+        switch(op)
+        {
+            case '|': left |= right; break;
+            case '^': left ^= right; break;
+            case '&': left &= right; break;
+            case '<': left = (int)((unsigned int)left << (right & 31)); break;
+            case '>': left >>= (right & 31); break;
+            case '+': left += right; break;
+            case '-': left -= right; break;
+            case '*': left *= right; break;
+            case '/':
+            case '%':
+                if(right == 0)
+                {
+                    if(!unresolved)
+                        error("division by zero");
+                    return 0;
+                }
+                left = op == '/' ? left / right : left % right;
+                break;
+        }
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   parseUnary
+*   DESCRIPTION :   Unary minus, complement and plus.
+*   ARGUMENTS   :   const char **p
+*   RETURNS     :   INT
+ *==============================================*/
+int parseUnary(const char **p)
+{
+    skipSpace(p);
+    if(**p == '-')
+    {
+        (*p)++;
+        return -parseUnary(p);
+    }
+    if(**p == '~')
+    {
+        (*p)++;
+        return ~parseUnary(p);
+    }
+    if(**p == '+')
+    {
+        (*p)++;
+        return parseUnary(p);
+    }
+    return parsePrimary(p);
+}
+
+/*===============================================
+*   FUNCTION    :   parsePrimary
+*   DESCRIPTION :   Numbers, character literals, symbols, $ and (expression).
+*   ARGUMENTS   :   const char **p
+*   RETURNS     :   INT
+ *==============================================*/
+int parsePrimary(const char **p)
+{
+    char name[MAX_NAME];
+    const char *s = *p;
+    Symbol *sym;
+    long value = 0;
+    int digit, base = 10;
+
+    if(*s == '(')
+    {
+        *p = s + 1;
+        value = parseExpression(p);
+        skipSpace(p);
+        if(**p != ')')
+        {
+            error("missing ')'");
+            return 0;
+        }
+        (*p)++;
+        return (int)value;
+    }
+    if(*s == '$')
+    {
+        *p = s + 1;
+        return location;
+    }
+    if(*s == '\'')
+    {
+        if(s[1] == '\0' || s[2] != '\'')
+        {
+            error("bad character literal");
+            return 0;
+        }
+        *p = s + 3;
+        return (unsigned char)s[1];
+    }
+    if(isdigit((unsigned char)*s))
+    {
+        if(s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+        {
+            base = 16;
+            s += 2;
+        }
+        else if(s[0] == '0' && (s[1] == 'b' || s[1] == 'B'))
+        {
+            base = 2;
+            s += 2;
+        }
+        for(;; s++)
+        {
+            if(isdigit((unsigned char)*s))
+                digit = *s - '0';
+            else if(isxdigit((unsigned char)*s))
+                digit = tolower((unsigned char)*s) - 'a' + 10;
+            else
+                break;
+            if(digit >= base)
+                break;
+            value = value * base + digit;
+            if(value > 0xFFFFFF)
+            {
+                error("number is too large");
+                return 0;
+            }
+        }
+        if(isalnum((unsigned char)*s) || *s == '_')
+        {
+            error("bad number");
+            return 0;
+        }
+        *p = s;
+        return (int)value;
+    }
+    if(readName(p, name) > 0)
+    {
+        sym = lookupSymbol(name, false);
+        if(sym == NULL)
+        {
+            unresolved = true;
+            if(pass == 2)
+                error("undefined symbol '%s'", name);
+            return 0;
+        }
+        return sym->value;
+    }
+    error("expected an expression");
+    return 0;
+}
+
+/*===============================================
+*   FUNCTION    :   lookupSymbol
+*   DESCRIPTION :   Finds a symbol in the open addressing hash table (FNV-1a,
+*                   linear probing). Slots of earlier files are treated as free.
+*   ARGUMENTS   :   const char *name, bool create
+*   RETURNS     :   Symbol* (NULL if not found or the table is full)
+ *==============================================*/
+Symbol *lookupSymbol(const char *name, bool create)
+{
+    unsigned int hash = 2166136261u, slot;
+    const char *c;
+
+    for(c = name; *c != '\0'; c++)
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+
+    for(slot = hash & (MAX_SYMBOLS - 1);; slot = (slot + 1) & (MAX_SYMBOLS - 1))
+    {
+        Symbol *sym = &symbols[slot];
+        if(sym->generation != generation)
+        {
+            if(!create || symbolCount >= MAX_SYMBOLS / 2)
+                return NULL;
+            strcpy(sym->name, name);
+            sym->hash = hash;
+            sym->generation = generation;
+            sym->line = 0;
+            symbolCount++;
+            return sym;
+        }
+        if(sym->hash == hash && strcmp(sym->name, name) == 0)
+            return sym;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   defineSymbol
+*   DESCRIPTION :   Defines a label or EQU constant during pass 1.
+*   ARGUMENTS   :   const char *name, int value
+*   RETURNS     :   VOID
+ *==============================================*/
+void defineSymbol(const char *name, int value)
+{
+    Symbol *sym;
+
+    if(findMnemonic(name) != NULL)
+    {
+        error("'%s' is a mnemonic and cannot be used as a symbol", name);
+        return;
+    }
+    sym = lookupSymbol(name, true);
+    if(sym == NULL)
+    {
+        error("too many symbols (limit %d)", MAX_SYMBOLS / 2);
+        return;
+    }
+    if(sym->line != 0)
+    {
+        error("'%s' is already defined on line %d", name, sym->line);
+        return;
+    }
+    sym->value = value;
+    sym->line = lineNumber;
+}
+
+/*===============================================
+*   FUNCTION    :   skipSpace
+*   DESCRIPTION :   Skips blanks.
+*   ARGUMENTS   :   const char **p
+*   RETURNS     :   VOID
+ *==============================================*/
+void skipSpace(const char **p)
+{
+    while(**p == ' ' || **p == '\t')
+        (*p)++;
+}
+
+/*===============================================
+*   FUNCTION    :   atEnd
+*   DESCRIPTION :   Checks for the end of the statement (end of line or comment).
+*   ARGUMENTS   :   const char **p
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool atEnd(const char **p)
+{
+    return **p == '\0' || **p == ';';
+}
+
+/*===============================================
+*   FUNCTION    :   readName
+*   DESCRIPTION :   Reads an identifier [A-Za-z_.][A-Za-z0-9_]*.
+*   ARGUMENTS   :   const char **p, char *name
+*   RETURNS     :   INT (length of the name, 0 if there is none)
+ *==============================================*/
+int readName(const char **p, char *name)
+{
+    const char *s = *p;
+    int n = 0;
+
+    if(!isalpha((unsigned char)*s) && *s != '_' && *s != '.')
+        return 0;
+    do
+    {
+        if(n < MAX_NAME - 1)
+            name[n] = *s;
+        n++;
+        s++;
+    } while(isalnum((unsigned char)*s) || *s == '_');
+
+    if(n >= MAX_NAME)
+    {
+        error("name is longer than %d characters", MAX_NAME - 1);
+        n = MAX_NAME - 1;
+    }
+    name[n] = '\0';
+    *p = s;
+    return n;
+}
+
+/*===============================================
+*   FUNCTION    :   findMnemonic
+*   DESCRIPTION :   Case-insensitive lookup of an instruction mnemonic.
+*   ARGUMENTS   :   const char *name
+*   RETURNS     :   const Mnemonic* (NULL if name is not an instruction)
+ *==============================================*/
+const Mnemonic *findMnemonic(const char *name)
+{
+    char upper[8];
+    size_t i, n = strlen(name);
+
+    if(n < 2 || n > 4)
+        return NULL;
+    for(i = 0; i <= n; i++)
+        upper[i] = (char)toupper((unsigned char)name[i]);
+    for(i = 0; i < MNEMONIC_COUNT; i++)
+        if(mnemonics[i].name[0] == upper[0] && strcmp(mnemonics[i].name, upper) == 0)
+            return &mnemonics[i];
+    return NULL;
+}
+
+/*===============================================
+*   FUNCTION    :   isDirective
+*   DESCRIPTION :   Case-insensitive match of a directive, with or without a
+*                   leading '.' (ORG and .org are the same).
+*   ARGUMENTS   :   const char *name, const char *directive
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool isDirective(const char *name, const char *directive)
+{
+    if(*name == '.')
+        name++;
+    while(*name != '\0' && toupper((unsigned char)*name) == *directive)
+    {
+        name++;
+        directive++;
+    }
+    return *name == '\0' && *directive == '\0';
+}
+
+/*===============================================
+*   FUNCTION    :   readSource
+*   DESCRIPTION :   Reads a whole file (or stdin) into memory.
+*   ARGUMENTS   :   FILE *fp, size_t *length
+*   RETURNS     :   char* (caller frees, NULL on failure)
+ *==============================================*/
+char *readSource(FILE *fp, size_t *length)
+{
+    size_t capacity = 4096, n = 0, got;
+    char *buffer = malloc(capacity), *grown;
+
+    while(buffer != NULL && (got = fread(buffer + n, 1, capacity - n, fp)) > 0)
+    {
+        n += got;
+        if(n == capacity)
+        {
+            capacity *= 2;
+            grown = realloc(buffer, capacity);
+            if(grown == NULL)
+                free(buffer);
+            buffer = grown;
+        }
+    }
+    if(buffer == NULL || ferror(fp))
+    {
+        free(buffer);
+        return NULL;
+    }
+    *length = n;
+    return buffer;
+}
+
+/*===============================================
+*   FUNCTION    :   writeImage
+*   DESCRIPTION :   Writes the assembled image in the selected format.
+*                   FORMAT_BIN writes image[0 .. imageSize-1]; FORMAT_C writes
+*                   one initMemory() statement per assembled byte.
+*   ARGUMENTS   :   const char *path ("-" for stdout)
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool writeImage(const char *path)
+{
+    FILE *fp = strcmp(path, "-") == 0 ? stdout : fopen(path, format == FORMAT_BIN ? "wb" : "w");
+    int i;
+    bool ok;
+
+    if(fp == NULL)
+    {
+        fprintf(stderr, "%s: cannot create file\n", path);
+        return false;
+    }
+    if(format == FORMAT_BIN)
+        fwrite(image, 1, (size_t)imageSize, fp);
+    else
+    {
+        for(i = 0; i < imageSize; i++)
+            if(used[i >> 3] & (1 << (i & 7)))
+                fprintf(fp, "    ADDR = 0x%02x; BUS = 0x%02x; MainMemory();\n", i, image[i]);
+    }
+    ok = !ferror(fp);
+    if(fp != stdout)
+        ok = (fclose(fp) == 0) && ok;
+    else
+        fflush(fp);
+    if(!ok)
+        fprintf(stderr, "%s: write failed\n", path);
+    return ok;
+}
+
+/*===============================================
+*   FUNCTION    :   outputPath
+*   DESCRIPTION :   Derives the output name from the source name by replacing
+*                   its extension (.bin or .c); stdin maps to stdout.
+*   ARGUMENTS   :   const char *input
+*   RETURNS     :   char* (caller frees)
+ *==============================================*/
+char *outputPath(const char *input)
+{
+    const char *ext = format == FORMAT_BIN ? ".bin" : ".c";
+    const char *dot = strrchr(input, '.');
+    const char *slash = strrchr(input, '/');
+    size_t stem;
+    char *path;
+
+    if(strcmp(input, "-") == 0)
+        return copyString("-");
+    if(dot == NULL || (slash != NULL && dot < slash))
+        stem = strlen(input);
+    else
+        stem = (size_t)(dot - input);
+
+    path = malloc(stem + strlen(ext) + 1);
+    if(path == NULL)
+        return NULL;
+    memcpy(path, input, stem);
+    strcpy(path + stem, ext);
+    return path;
+}
+
+/*===============================================
+*   FUNCTION    :   copyString
+*   DESCRIPTION :   strdup(), which is not part of C99.
+*   ARGUMENTS   :   const char *text
+*   RETURNS     :   char* (caller frees, NULL if out of memory)
+ *==============================================*/
+char *copyString(const char *text)
+{
+    char *copy = malloc(strlen(text) + 1);
+
+    if(copy != NULL)
+        strcpy(copy, text);
+    return copy;
+}
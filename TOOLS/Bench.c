@@ -0,0 +1,311 @@
+ /*======================================================================================================
+* FILE        : Bench.c
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : Benchmark driver. Runs a simulator on every image a number of times, reads the
+*               simulated instructions and cycles from the "N instructions, M cycles" line the
+*               simulator prints, times every run on the wall clock and writes the results as
+*               JSON: the median and fastest wall time and the simulated MIPS (millions of
+*               instructions per second of the median run) of each image. The wall time is that of
+*               the whole process, loading the image included.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+======================================================================================================*/
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // popen, clock_gettime
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/wait.h>
+#else
+#include <windows.h>
+#define popen _popen
+#define pclose _pclose
+#endif
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define MAX_REPETITIONS 100
+#define DEFAULT_REPETITIONS 3
+#define MAX_COMMAND 4096
+#define MAX_LINE 512
+
+typedef struct
+{
+    const char *image;
+    char name[64];                  // file name of the image without directory and extension
+    int status;                     // exit status of the simulator, -1 if it could not run
+    unsigned long long instructions, cycles;
+    bool counted;                   // the counts line was found, and was the same in every run
+    double wall[MAX_REPETITIONS];   // seconds, sorted after the last run
+} Result;
+
+/*===============================================
+ *   FUNCTION PROTOTYPES
+ *==============================================*/
+bool runOnce(const char *simulator, Result *result, int repetition);
+void writeJSON(FILE *fp, const char *simulator, const Result *results, int count, int repetitions);
+void writeString(FILE *fp, const char *text);
+void baseName(const char *path, char *name, size_t size);
+int compareSeconds(const void *a, const void *b);
+double wallClock(void);
+
+/*===============================================
+*   FUNCTION    :   MAIN
+*   DESCRIPTION :   Runs the suite and prints or writes its JSON.
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 if every image reached EOP, 1 otherwise)
+ *==============================================*/
+int main(int argc, char *argv[])
+{
+    const char *simulator = NULL, *output = NULL;
+    int repetitions = DEFAULT_REPETITIONS, count = 0, i, r, failed = 0;
+    Result *results;
+    FILE *fp;
+
+    results = calloc((size_t)argc, sizeof(Result));
+    if(results == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return 1;
+    }
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repetitions = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if(argv[i][0] == '-')
+        {
+            simulator = NULL;
+            break;
+        }
+        else if(simulator == NULL)
+            simulator = argv[i];
+        else
+        {
+            results[count].image = argv[i];
+            baseName(argv[i], results[count].name, sizeof(results[count].name));
+            count++;
+        }
+    }
+    if(simulator == NULL || count == 0 || repetitions < 1 || repetitions > MAX_REPETITIONS)
+    {
+        fprintf(stderr, "Usage: %s [-r repetitions] [-o results.json] \"simulator [options]\" image.bin ...\n", argv[0]);
+        fprintf(stderr, "  -r  runs of every image, the median wall time is reported (default %d, at most %d)\n",
+                DEFAULT_REPETITIONS, MAX_REPETITIONS);
+        fprintf(stderr, "  -o  writes the JSON to a file instead of stdout\n");
+        free(results);
+        return 1;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        for(r = 0; r < repetitions; r++)
+        {
+            if(!runOnce(simulator, &results[i], r))
+                break;
+        }
+        if(r < repetitions)
+        {
+            failed++;
+            fprintf(stderr, "%s: %s\n", results[i].name, results[i].counted ? "stopped before EOP" : "no instruction count");
+            continue;
+        }
+        qsort(results[i].wall, (size_t)repetitions, sizeof(double), compareSeconds);
+        fprintf(stderr, "%-16s %12llu instructions %8.3f s %8.2f MIPS\n", results[i].name, results[i].instructions,
+                results[i].wall[repetitions / 2], results[i].instructions / results[i].wall[repetitions / 2] / 1e6);
+    }
+
+    fp = output != NULL ? fopen(output, "w") : stdout;
+    if(fp == NULL)
+    {
+        fprintf(stderr, "%s: cannot create file\n", output);
+        free(results);
+        return 1;
+    }
+    writeJSON(fp, simulator, results, count, repetitions);
+    if(fp != stdout)
+        fclose(fp);
+    free(results);
+    return failed > 0;
+}
+
+/*===============================================
+*   FUNCTION    :   runOnce
+*   DESCRIPTION :   Runs the simulator on the image of a result once and keeps
+*                   the wall time of the run. The counts of later runs have
+*                   to be those of the first.
+*   ARGUMENTS   :   const char *simulator, Result *result, int repetition
+*   RETURNS     :   BOOL (false if the run did not reach EOP or gave no counts)
+ *==============================================*/
+bool runOnce(const char *simulator, Result *result, int repetition)
+{
+    char command[MAX_COMMAND], line[MAX_LINE];
+    unsigned long long instructions = 0, cycles = 0;
+    bool counted = false;
+    double start;
+    FILE *pipe;
+    int status;
+
+    snprintf(command, sizeof(command), "%s \"%s\"", simulator, result->image);
+    start = wallClock();
+    pipe = popen(command, "r");
+    if(pipe == NULL)
+    {
+        result->status = -1;
+        return false;
+    }
+    while(fgets(line, sizeof(line), pipe) != NULL)
+    {
+        if(sscanf(line, "%llu instructions, %llu cycles", &instructions, &cycles) == 2)
+            counted = true;
+    }
+    status = pclose(pipe);
+    result->wall[repetition] = wallClock() - start;
+#ifndef _WIN32
+    status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+    result->status = status;
+
+    if(repetition == 0)
+    {
+        result->counted = counted;
+        result->instructions = instructions;
+        result->cycles = cycles;
+    }
+    else if(!counted || instructions != result->instructions || cycles != result->cycles)
+        result->counted = false;
+    return status == 0 && result->counted;
+}
+
+/*===============================================
+*   FUNCTION    :   writeJSON
+*   DESCRIPTION :   Writes the results, one object per image. Images that
+*                   failed have their status and null timings.
+*   ARGUMENTS   :   FILE *fp, const char *simulator, const Result *results, int count, int repetitions
+*   RETURNS     :   VOID
+ *==============================================*/
+void writeJSON(FILE *fp, const char *simulator, const Result *results, int count, int repetitions)
+{
+    const Result *result;
+    double median;
+    int i;
+
+    fprintf(fp, "{\n  \"simulator\": ");
+    writeString(fp, simulator);
+    fprintf(fp, ",\n  \"repetitions\": %d,\n  \"benchmarks\": [\n", repetitions);
+    for(i = 0; i < count; i++)
+    {
+        result = &results[i];
+        fprintf(fp, "    {\"name\": ");
+        writeString(fp, result->name);
+        fprintf(fp, ", \"image\": ");
+        writeString(fp, result->image);
+        fprintf(fp, ", \"status\": %d, ", result->status);
+        if(result->status == 0 && result->counted)
+        {
+            median = result->wall[repetitions / 2];
+            fprintf(fp, "\"instructions\": %llu, \"cycles\": %llu, \"wall_seconds\": %.6f, \"wall_seconds_min\": %.6f, "
+                        "\"mips\": %.3f}",
+                    result->instructions, result->cycles, median, result->wall[0], result->instructions / median / 1e6);
+        }
+        else
+            fprintf(fp, "\"instructions\": null, \"cycles\": null, \"wall_seconds\": null, \"wall_seconds_min\": null, "
+                        "\"mips\": null}");
+        fprintf(fp, "%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+/*===============================================
+*   FUNCTION    :   writeString
+*   DESCRIPTION :   Writes text as a JSON string.
+*   ARGUMENTS   :   FILE *fp, const char *text
+*   RETURNS     :   VOID
+ *==============================================*/
+void writeString(FILE *fp, const char *text)
+{
+    fputc('"', fp);
+    for(; *text != '\0'; text++)
+    {
+        if(*text == '"' || *text == '\\')
+            fprintf(fp, "\\%c", *text);
+        else if((unsigned char)*text < 0x20)
+            fprintf(fp, "\\u%04x", (unsigned char)*text);
+        else
+            fputc(*text, fp);
+    }
+    fputc('"', fp);
+}
+
+/*===============================================
+*   FUNCTION    :   baseName
+*   DESCRIPTION :   File name of a path without its directory and extension.
+*   ARGUMENTS   :   const char *path, char *name, size_t size
+*   RETURNS     :   VOID
+ *==============================================*/
+void baseName(const char *path, char *name, size_t size)
+{
+    const char *start = path, *p, *dot = NULL;
+    size_t length;
+
+    for(p = path; *p != '\0'; p++)
+    {
+        if(*p == '/' || *p == '\\')
+            start = p + 1, dot = NULL;
+        else if(*p == '.')
+            dot = p;
+    }
+    length = (dot != NULL && dot > start ? (size_t)(dot - start) : strlen(start));
+    if(length >= size)
+        length = size - 1;
+    memcpy(name, start, length);
+    name[length] = '\0';
+}
+
+/*===============================================
+*   FUNCTION    :   compareSeconds
+*   DESCRIPTION :   qsort() order of wall times.
+*   ARGUMENTS   :   const void *a, const void *b
+*   RETURNS     :   INT
+ *==============================================*/
+int compareSeconds(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*===============================================
+*   FUNCTION    :   wallClock
+*   DESCRIPTION :   Seconds on a monotonic clock.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   DOUBLE
+ *==============================================*/
+double wallClock(void)
+{
+#ifndef _WIN32
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#else
+    LARGE_INTEGER now, frequency;
+
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    return (double)now.QuadPart / frequency.QuadPart;
+#endif
+}
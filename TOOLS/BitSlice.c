@@ -0,0 +1,635 @@
+ /*======================================================================================================
+* FILE        : BitSlice.c
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : Bit-sliced runner for program images. Bit L of every host word belongs to machine
+*               instance L, so one pass over a register's bit planes runs an ALU operation or a
+*               memory access for 64 instances at once, the way LE6 keeps memory in bit planes of
+*               chips. The instances share one PC: they are meant to follow the same control flow
+*               (exhaustive inputs, fault injection). An instance that fetches another instruction
+*               or takes another branch than the reference (lowest live) instance is retired and
+*               reported. The CU and ALU behave as in LE6; the instruction codes and cycle counts
+*               are those of CORE/Core.h. The ALU works on bit planes, 64 instances an operation,
+*               so it keeps its own bit-sliced form of coreALU(). Of the IO devices only the seven
+*               segment output and an input stream without input are modeled; interrupts, DMA,
+*               the timer, banks, counter and byte pipe are not.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+*   19 October, 2026: V1.1 - Instruction codes, IO addresses and cycles from CORE/Core.h
+======================================================================================================*/
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include "../CORE/Core.h"
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define LANES 64                // instances per host word
+#define ALL_LANES 0xFFFFFFFFFFFFFFFFull
+#define ACC_BITS 32             // ACC is an unsigned int in LE6, NOT and SHL reach past bit 15
+#define MAX_VARIANTS 16
+#define DEFAULT_BUDGET 100000000ull
+
+// IO addresses past the ones of CORE/Core.h; IO_SEGMENT writes are outputs of the instance,
+// the input stream has no input (no byte, end of input) and the input latches read as 0
+#define IO_DEVICES 0x020        // interrupts, DMA, timer, bank select, counter, byte pipe: not modeled
+#define IO_LAST_DEVICE 0x035
+
+// Variants, what makes the instances differ
+#define VARIANT_LANE 0          // the byte at address holds the lane number
+#define VARIANT_FAULT 1         // lane L > 0 has bit (L-1)%8 of address + (L-1)/8 flipped
+
+typedef uint64_t Lanes;         // bit L belongs to instance L
+
+typedef struct
+{
+    int kind;
+    unsigned int address;
+} Variant;
+
+/*===============================================
+ *   GLOBAL VARIABLES
+ *==============================================*/
+Lanes memory[MEMORY_SIZE][8];   // plane b holds bit b of the byte in every instance
+Lanes acc[ACC_BITS], mbr[8], iobr[8], bus[8];
+Lanes zf = 0, cf = 0, sf = 0, of = 0; // FLAGS bits
+Lanes active = ALL_LANES;       // instances still on the shared control flow
+unsigned int pc = 0, instAddress = 0; // instAddress: the instruction being executed
+unsigned long long instructionCount = 0, cycleCount = 0, budget = DEFAULT_BUDGET;
+bool ended = false;             // EOP reached
+bool deviceWarned = false;
+
+// per instance results
+unsigned long long outputCount[LANES], outputHash[LANES];
+unsigned int lastOutput[LANES];
+unsigned long long retiredAt[LANES];    // instruction count when the instance left the control flow
+unsigned int retiredPC[LANES];
+const char *retiredWhy[LANES];
+
+Variant variants[MAX_VARIANTS];
+int variantCount = 0;
+bool summaryOnly = false;
+
+/*===============================================
+ *   FUNCTION PROTOTYPES
+ *==============================================*/
+bool loadImage(const char *path);
+void applyVariant(const Variant *v);
+void run(void);
+void step(void);
+void report(void);
+
+// bit plane helpers
+unsigned int physical(unsigned int address);
+void broadcast(Lanes *planes, int width, unsigned int value);
+unsigned int laneValue(const Lanes *planes, int width, int lane);
+Lanes agree(const Lanes *planes, int width, unsigned int value);
+int referenceLane(void);
+void retire(Lanes lanes, const char *why);
+Lanes add8(Lanes *sum, const Lanes *a, const Lanes *b);
+void negate8(Lanes *out, const Lanes *in);
+Lanes isZero(const Lanes *planes, int width);
+Lanes anySet(const Lanes *planes, int from, int to);
+
+// CU and ALU
+void alu(unsigned int control);
+void booth(void);
+void output(void);
+
+/*===============================================
+*   FUNCTION    :   MAIN
+*   DESCRIPTION :   Loads an image into all instances, applies the variants
+*                   and runs them together.
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 if the run completed, 1 on errors)
+ *==============================================*/
+int main(int argc, char *argv[])
+{
+    const char *image = NULL;
+    int i;
+
+    for(i = 1; i < argc; i++)
+    {
+        if((strcmp(argv[i], "-x") == 0 || strcmp(argv[i], "-f") == 0) && i + 1 < argc && variantCount < MAX_VARIANTS)
+        {
+            variants[variantCount].kind = argv[i][1] == 'x' ? VARIANT_LANE : VARIANT_FAULT;
+            variants[variantCount++].address = (unsigned int)strtoul(argv[++i], NULL, 0) & OPERAND_MASK;
+        }
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            budget = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-s") == 0)
+            summaryOnly = true;
+        else if(argv[i][0] == '-' || image != NULL)
+        {
+            image = NULL;
+            break;
+        }
+        else
+            image = argv[i];
+    }
+    if(image == NULL)
+    {
+        fprintf(stderr, "Usage: %s [-x address] [-f address] [-i instructions] [-s] image.bin\n", argv[0]);
+        fprintf(stderr, "  -x  the byte at address holds the lane number (0 - 63) in every instance\n");
+        fprintf(stderr, "  -f  instance L > 0 has bit (L-1)%%8 of address + (L-1)/8 flipped, 0 is the golden run\n");
+        fprintf(stderr, "  -i  instruction budget (default %llu)\n", DEFAULT_BUDGET);
+        fprintf(stderr, "  -s  only print the instances that differ from instance 0\n");
+        return 1;
+    }
+    if(!loadImage(image))
+        return 1;
+    for(i = 0; i < variantCount; i++)
+        applyVariant(&variants[i]);
+
+    run();
+    report();
+    return 0;
+}
+
+/*===============================================
+*   FUNCTION    :   loadImage
+*   DESCRIPTION :   Reads a binary image into every instance, byte n of the file
+*                   being address n.
+*   ARGUMENTS   :   const char *path
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool loadImage(const char *path)
+{
+    unsigned char image[MEMORY_SIZE];
+    FILE *fp = fopen(path, "rb");
+    int i;
+
+    if(fp == NULL)
+    {
+        fprintf(stderr, "%s: cannot open file\n", path);
+        return false;
+    }
+    memset(image, 0, sizeof(image));
+    fread(image, 1, sizeof(image), fp);
+    if(fgetc(fp) != EOF)
+    {
+        fprintf(stderr, "%s: image is larger than the %d byte main memory\n", path, MEMORY_SIZE);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    for(i = 0; i < MEMORY_SIZE; i++)
+        broadcast(memory[i], 8, image[i]);
+    return true;
+}
+
+/*===============================================
+*   FUNCTION    :   applyVariant
+*   DESCRIPTION :   Makes the instances differ in memory before the run.
+*   ARGUMENTS   :   const Variant *v
+*   RETURNS     :   VOID
+ *==============================================*/
+void applyVariant(const Variant *v)
+{
+    int lane, b;
+
+    for(lane = 0; lane < LANES; lane++)
+    {
+        if(v->kind == VARIANT_LANE)
+        {
+            for(b = 0; b < 8; b++)
+            {
+                memory[v->address][b] &= ~(1ull << lane);
+                memory[v->address][b] |= (Lanes)((lane >> b) & 1) << lane;
+            }
+        }
+        else if(lane > 0)
+            memory[(v->address + (lane - 1) / 8) & OPERAND_MASK][(lane - 1) % 8] ^= 1ull << lane;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   run
+*   DESCRIPTION :   Steps all instances until EOP, the budget, or until every
+*                   instance has been retired.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void run(void)
+{
+    memset(acc, 0, sizeof(acc));
+    memset(mbr, 0, sizeof(mbr));
+    memset(iobr, 0, sizeof(iobr));
+    memset(bus, 0, sizeof(bus));
+    while(!ended && active != 0 && instructionCount < budget)
+        step();
+}
+
+/*===============================================
+*   FUNCTION    :   step
+*   DESCRIPTION :   Fetches, decodes and executes one instruction in every live
+*                   instance, like one pass of the loop in CU().
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void step(void)
+{
+    Lanes *hi, *lo, taken, write;
+    unsigned int ir, inst_code, operand, address, value;
+    int ref = referenceLane(), i;
+
+    /* fetch, the instances that read another instruction leave */
+    hi = memory[physical(pc)];
+    lo = memory[physical(pc + 1)];
+    ir = (laneValue(hi, 8, ref) << 8) | laneValue(lo, 8, ref);
+    instAddress = pc;
+    instructionCount++;
+    retire(active & ~(agree(hi, 8, ir >> 8) & agree(lo, 8, ir & 0xFF)), "fetched another instruction");
+    pc += 2;
+
+    inst_code = ir >> 11;
+    operand = ir & OPERAND_MASK;
+    cycleCount += coreCycles[inst_code];
+
+    switch(inst_code)
+    {
+        case OP_WM:
+            memcpy(bus, mbr, sizeof(bus));
+            address = physical(operand);
+            for(i = 0; i < 8; i++) // retired instances keep their memory as it was
+                memory[address][i] = (bus[i] & active) | (memory[address][i] & ~active);
+            break;
+        case OP_RM:
+            memcpy(bus, memory[physical(operand)], sizeof(bus));
+            memcpy(mbr, bus, sizeof(mbr));
+            break;
+        case OP_BR:
+            pc = operand;
+            break;
+        case OP_RIO:
+            if(operand == IO_INPUT_STATUS)
+                broadcast(bus, 8, IO_INPUT_END);
+            else if(operand == IO_INPUT_DATA || operand == IO_INPUT_COUNT
+                    || (operand >= IO_INPUT_LATCHES && operand <= IO_LAST_LATCH))
+                broadcast(bus, 8, 0);
+            else if(operand >= IO_DEVICES && operand <= IO_LAST_DEVICE && !deviceWarned)
+            {
+                fprintf(stderr, "Warning: IO device at 0x%03x is not modeled, BUS is left as is\n", operand);
+                deviceWarned = true;
+            } // unmapped and write-only addresses leave BUS as is
+            memcpy(iobr, bus, sizeof(iobr));
+            break;
+        case OP_WIO:
+            memcpy(bus, iobr, sizeof(bus));
+            if(operand == IO_SEGMENT)
+                output();
+            else if(operand >= IO_DEVICES && operand <= IO_LAST_DEVICE && !deviceWarned)
+            {
+                fprintf(stderr, "Warning: IO device at 0x%03x is not modeled, the write is ignored\n", operand);
+                deviceWarned = true;
+            }
+            break;
+        case OP_WB:
+            broadcast(mbr, 8, operand & 0xFF); // only the low byte of MBR ever reaches the BUS
+            break;
+        case OP_WIB:
+            broadcast(iobr, 8, operand & 0xFF);
+            break;
+        case OP_WACC:
+            memcpy(bus, mbr, sizeof(bus));
+            alu(OP_WACC);
+            break;
+        case OP_RACC:
+            alu(OP_RACC);
+            memcpy(mbr, bus, sizeof(mbr));
+            break;
+        case OP_SWAP:
+            for(i = 0; i < 8; i++)
+            {
+                write = iobr[i];
+                iobr[i] = mbr[i];
+                mbr[i] = write;
+            }
+            break;
+        case OP_BRLT: case OP_BRGT: case OP_BRNE: case OP_BRE:
+            memcpy(bus, mbr, sizeof(bus));
+            alu(OP_SUB); // compare: ACC <- ACC - BUS
+            taken = inst_code == OP_BRLT ? sf : inst_code == OP_BRGT ? ~sf : inst_code == OP_BRNE ? ~zf : zf;
+            value = (unsigned int)(taken >> ref) & 1;
+            retire(active & (value ? ~taken : taken), "took the other branch");
+            if(value)
+                pc = operand;
+            break;
+        case OP_SHR: case OP_SHL: case OP_XOR: case OP_NOT: case OP_OR: case OP_AND:
+        case OP_MUL: case OP_SUB: case OP_ADD:
+            memcpy(bus, mbr, sizeof(bus));
+            alu(inst_code);
+            break;
+        case OP_EOP:
+            ended = true;
+            break;
+        default: // RETI outside a handler and the unused codes change nothing
+            break;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   alu
+*   DESCRIPTION :   The ALU of LE6 on bit planes: add and subtract with ripple
+*                   carries, Booth multiplication, logic and shifts, and the
+*                   flags the operation affects.
+*   ARGUMENTS   :   UNSIGNED INT control
+*   RETURNS     :   VOID
+ *==============================================*/
+void alu(unsigned int control)
+{
+    Lanes operand[8], sum[8], carry;
+    int i;
+
+    switch(control)
+    {
+        case OP_ADD: case OP_SUB:
+            if(control == OP_SUB)
+                negate8(operand, bus);
+            else
+                memcpy(operand, bus, sizeof(operand));
+            carry = add8(sum, acc, operand);
+            of = (acc[7] ^ sum[7]) & (operand[7] ^ sum[7]);
+            cf = carry;
+            memcpy(acc, sum, sizeof(sum));
+            memset(&acc[8], 0, sizeof(Lanes) * (ACC_BITS - 8));
+            zf = isZero(acc, 8);
+            sf = acc[7];
+            break;
+        case OP_MUL:
+            booth();
+            zf = isZero(acc, 16);
+            sf = acc[15];
+            of = cf = anySet(acc, 8, 15);
+            break;
+        case OP_AND: case OP_OR: case OP_XOR: case OP_NOT:
+            for(i = 0; i < ACC_BITS; i++)
+            {
+                if(control == OP_AND)
+                    acc[i] = i < 8 ? acc[i] & bus[i] : 0;
+                else if(control == OP_OR)
+                    acc[i] |= i < 8 ? bus[i] : 0;
+                else if(control == OP_XOR)
+                    acc[i] ^= i < 8 ? bus[i] : 0;
+                else
+                    acc[i] = ~acc[i];
+            }
+            zf = isZero(acc, ACC_BITS);
+            break;
+        case OP_SHL:
+            cf = acc[15];
+            memmove(&acc[1], &acc[0], sizeof(Lanes) * (ACC_BITS - 1));
+            acc[0] = 0;
+            break;
+        case OP_SHR:
+            cf = acc[0];
+            memmove(&acc[0], &acc[1], sizeof(Lanes) * (ACC_BITS - 1));
+            acc[ACC_BITS - 1] = 0;
+            break;
+        case OP_WACC:
+            memcpy(acc, bus, sizeof(bus));
+            memset(&acc[16], 0, sizeof(Lanes) * (ACC_BITS - 16));
+            break;
+        case OP_RACC:
+            memcpy(bus, acc, sizeof(bus));
+            break;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   booth
+*   DESCRIPTION :   boothsAlogrithm() of LE6 with M = ACC (low byte) and Q = BUS,
+*                   step for step. Like the original, the bit shifted into Q
+*                   is the LSB of A before the addition.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void booth(void)
+{
+    Lanes m[8], minusM[8], q[8], a[8], addend[8], qn1 = 0, lsbQ, lsbA, subtract, add;
+    int n, i;
+
+    memcpy(m, acc, sizeof(m));
+    memcpy(q, bus, sizeof(q));
+    memset(a, 0, sizeof(a));
+    negate8(minusM, m);
+    for(n = 0; n < 8; n++)
+    {
+        lsbQ = q[0];
+        lsbA = a[0];
+        subtract = lsbQ & ~qn1; // 10
+        add = ~lsbQ & qn1;      // 01
+        for(i = 0; i < 8; i++)
+            addend[i] = (subtract & minusM[i]) | (add & m[i]);
+        add8(a, a, addend);
+        memmove(&a[0], &a[1], sizeof(Lanes) * 7); // arithmetic shift, a[7] stays
+        memmove(&q[0], &q[1], sizeof(Lanes) * 7);
+        q[7] = lsbA;
+        qn1 = lsbQ;
+    }
+    memcpy(&acc[0], q, sizeof(q));
+    memcpy(&acc[8], a, sizeof(a));
+    memset(&acc[16], 0, sizeof(Lanes) * (ACC_BITS - 16));
+}
+
+/*===============================================
+*   FUNCTION    :   output
+*   DESCRIPTION :   Records a write to the seven segment display in every live
+*                   instance (count, last value and an FNV-1a hash).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void output(void)
+{
+    int lane;
+    unsigned int value;
+
+    for(lane = 0; lane < LANES; lane++)
+    {
+        if(!((active >> lane) & 1))
+            continue;
+        value = laneValue(bus, 8, lane);
+        if(outputCount[lane]++ == 0)
+            outputHash[lane] = 0xCBF29CE484222325ull;
+        outputHash[lane] = (outputHash[lane] ^ value) * 0x100000001B3ull;
+        lastOutput[lane] = value;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   report
+*   DESCRIPTION :   Prints the run and the result of every instance.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void report(void)
+{
+    int lane, live = 0;
+    bool same;
+
+    for(lane = 0; lane < LANES; lane++)
+        live += (int)((active >> lane) & 1);
+    printf("%llu instructions, %llu cycles, %s, %d of %d instances on the control flow\n",
+           instructionCount, cycleCount, ended ? "EOP reached" : active == 0 ? "all instances retired" : "budget exhausted",
+           live, LANES);
+    for(lane = 0; lane < LANES; lane++)
+    {
+        // instance 0 is the reference while it lives, and it always does
+        same = ((active >> lane) & 1) && outputCount[lane] == outputCount[0] && outputHash[lane] == outputHash[0]
+               && laneValue(acc, ACC_BITS, lane) == laneValue(acc, ACC_BITS, 0);
+        if(summaryOnly && lane > 0 && same)
+            continue;
+        printf("lane %2d: ", lane);
+        if(!((active >> lane) & 1))
+            printf("%s at instruction %llu (0x%03x)\n", retiredWhy[lane], retiredAt[lane], retiredPC[lane]);
+        else
+            printf("%llu outputs, last %u, hash %016llx, ACC 0x%04x\n",
+                   outputCount[lane], lastOutput[lane], outputHash[lane], laneValue(acc, ACC_BITS, lane));
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   physical
+*   DESCRIPTION :   Cell MainMemory() reaches for an address, an address past
+*                   0x7FF still selects chip group B (cs = ADDR >> 10 != 0).
+*   ARGUMENTS   :   UNSIGNED INT address
+*   RETURNS     :   UNSIGNED INT
+ *==============================================*/
+unsigned int physical(unsigned int address)
+{
+    return (address & 0x3FF) | ((address >> 10) ? 0x400 : 0);
+}
+
+/*===============================================
+*   FUNCTION    :   broadcast / laneValue / agree
+*   DESCRIPTION :   The same value in every instance, the value of one instance,
+*                   and the instances whose planes hold a given value.
+*   ARGUMENTS   :   Lanes *planes, int width, UNSIGNED INT value / INT lane
+*   RETURNS     :   VOID / UNSIGNED INT / Lanes
+ *==============================================*/
+void broadcast(Lanes *planes, int width, unsigned int value)
+{
+    int i;
+
+    for(i = 0; i < width; i++)
+        planes[i] = ((value >> i) & 1) ? ALL_LANES : 0;
+}
+
+unsigned int laneValue(const Lanes *planes, int width, int lane)
+{
+    unsigned int value = 0;
+    int i;
+
+    for(i = 0; i < width; i++)
+        value |= (unsigned int)((planes[i] >> lane) & 1) << i;
+    return value;
+}
+
+Lanes agree(const Lanes *planes, int width, unsigned int value)
+{
+    Lanes lanes = ALL_LANES;
+    int i;
+
+    for(i = 0; i < width; i++)
+        lanes &= ((value >> i) & 1) ? planes[i] : ~planes[i];
+    return lanes;
+}
+
+/*===============================================
+*   FUNCTION    :   referenceLane / retire
+*   DESCRIPTION :   The lowest live instance decides the control flow, the
+*                   live instances that disagree with it are retired.
+*   ARGUMENTS   :   VOID / Lanes lanes, const char *why
+*   RETURNS     :   INT / VOID
+ *==============================================*/
+int referenceLane(void)
+{
+    int lane = 0;
+
+    while(!((active >> lane) & 1))
+        lane++;
+    return lane;
+}
+
+void retire(Lanes lanes, const char *why)
+{
+    int lane;
+
+    lanes &= active;
+    for(lane = 0; lanes != 0 && lane < LANES; lane++)
+    {
+        if((lanes >> lane) & 1)
+        {
+            retiredAt[lane] = instructionCount;
+            retiredPC[lane] = instAddress;
+            retiredWhy[lane] = why;
+        }
+    }
+    active &= ~lanes;
+}
+
+/*===============================================
+*   FUNCTION    :   add8 / negate8
+*   DESCRIPTION :   8-bit ripple carry addition (sum may be a) and two's
+*                   complement, on bit planes.
+*   ARGUMENTS   :   Lanes *sum, const Lanes *a, const Lanes *b / Lanes *out, const Lanes *in
+*   RETURNS     :   Lanes (carry out of bit 7) / VOID
+ *==============================================*/
+Lanes add8(Lanes *sum, const Lanes *a, const Lanes *b)
+{
+    Lanes carry = 0, x, generate;
+    int i;
+
+    for(i = 0; i < 8; i++)
+    {
+        x = a[i] ^ b[i];
+        generate = a[i] & b[i];
+        sum[i] = x ^ carry;
+        carry = generate | (carry & x);
+    }
+    return carry;
+}
+
+void negate8(Lanes *out, const Lanes *in)
+{
+    Lanes carry = ALL_LANES, x;
+    int i;
+
+    for(i = 0; i < 8; i++)
+    {
+        x = ~in[i];
+        out[i] = x ^ carry;
+        carry &= x;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   isZero / anySet
+*   DESCRIPTION :   Instances whose planes are all 0, or have a bit set in
+*                   planes from - to.
+*   ARGUMENTS   :   const Lanes *planes, int width / int from, int to
+*   RETURNS     :   Lanes
+ *==============================================*/
+Lanes isZero(const Lanes *planes, int width)
+{
+    return ~anySet(planes, 0, width - 1);
+}
+
+Lanes anySet(const Lanes *planes, int from, int to)
+{
+    Lanes lanes = 0;
+    int i;
+
+    for(i = from; i <= to; i++)
+        lanes |= planes[i];
+    return lanes;
+}
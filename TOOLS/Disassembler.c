@@ -0,0 +1,1852 @@
+ /*======================================================================================================
+* FILE        : Disassembler.c
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : Disassembler and static analyzer for program images. Decodes an image the same way
+*               the CU does (IR>>11 / IR & 0x07FF), follows the branch opcodes to build a control
+*               flow graph, and reports images that should not be given simulation time.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+*   19 October, 2026: V1.1 - Static loop-bound and instruction/cycle count estimator (-e)
+*   19 October, 2026: V1.2 - RETI, interrupt handler entry points (-v)
+*   19 October, 2026: V1.3 - Accepts programs that patch the operand of their own RM/WM
+*   19 October, 2026: V1.4 - The listing (-d) keeps the trailing zero bytes of the image
+======================================================================================================*/
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdarg.h>
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define MEMORY_SIZE 2048        // 11-bit address space of the main memory
+#define OPERAND_MASK 0x07FF     // lower 11 bits of IR
+#define MAX_BLOCKS MEMORY_SIZE  // every instruction could be its own block
+#define MAX_ENTRIES 16
+#define MAX_LOOPS 256
+#define MAX_CELLS 256           // memory cells written by WM that the estimator tracks
+#define UNBOUNDED 0xFFFFFFFFFFFFFFFFull
+
+// Operand kinds
+#define OPERAND_NONE 0          // implicit operation, operand bits unused
+#define OPERAND_ADDRESS 1       // memory, IO or branch address (0x000 - 0x7FF)
+#define OPERAND_DATA 2          // literal loaded to MBR/IOBR
+
+// Per byte attributes
+#define BYTE_CODE 0x01          // byte belongs to a reachable instruction
+#define BYTE_START 0x02         // first byte of a reachable instruction
+#define BYTE_LEADER 0x04        // first instruction of a basic block
+#define BYTE_TARGET 0x08        // branch target (gets a label)
+#define BYTE_READ 0x10          // operand of a reachable RM
+#define BYTE_WRITTEN 0x20       // operand of a reachable WM
+#define BYTE_PATCHED 0x40       // lower byte of a reachable RM/WM that a WM rewrites (operand patch)
+#define BYTE_MAY_WRITE 0x80     // in the page a patched WM can write
+#define PAGE_MASK 0x0700        // operand bits a patch leaves as they are
+
+// Instruction codes used by the control flow analysis
+#define OP_WM 0x01
+#define OP_RM 0x02
+#define OP_BR 0x03
+#define OP_RIO 0x04
+#define OP_WB 0x06
+#define OP_WIB 0x07
+#define OP_WACC 0x09
+#define OP_RACC 0x0B
+#define OP_SWAP 0x0E
+#define OP_BRLT 0x11
+#define OP_BRGT 0x12
+#define OP_BRNE 0x13
+#define OP_BRE 0x14
+#define OP_SHR 0x15
+#define OP_SHL 0x16
+#define OP_XOR 0x17
+#define OP_NOT 0x18
+#define OP_OR 0x19
+#define OP_AND 0x1A
+#define OP_MUL 0x1B
+#define OP_SUB 0x1D
+#define OP_ADD 0x1E
+#define OP_EOP 0x1F
+#define OP_RETI 0x08
+
+// Estimator value kinds
+#define VAL_TOP 0               // no value yet (constant propagation)
+#define VAL_CONST 1             // known 8-bit value
+#define VAL_AFFINE 2            // value of variable 'var' at the loop header plus 'value' (mod 256)
+#define VAL_UNKNOWN 3
+
+// Estimator variables
+#define VAR_ACC 0               // low byte of ACC
+#define VAR_MBR 1
+#define VAR_IOBR 2
+#define VAR_CELLS 3             // first tracked memory cell
+#define MAX_VARS (VAR_CELLS + MAX_CELLS)
+
+typedef struct
+{
+    const char *name;
+    unsigned char kind;
+} Opcode;
+
+typedef struct
+{
+    int start;                  // address of the first instruction
+    int last;                   // address of the last instruction
+    int count;                  // number of instructions
+    int succ[2];                // successor block start addresses
+    int nsucc;
+} Block;
+
+typedef struct
+{
+    unsigned char kind;
+    short var;
+    unsigned int value;
+} Value;
+
+typedef struct
+{
+    Value accHigh;              // ACC bits above the low byte (VAL_CONST or VAL_UNKNOWN)
+    Value v[MAX_VARS];
+} State;
+
+typedef struct
+{
+    int header;                 // block index of the loop header
+    int parent;                 // enclosing loop, -1 at top level
+    int size;                   // number of blocks in the body
+    int last;                   // highest instruction address in the body
+    bool preInParent;           // loop sits before the exit branch of the parent's cycle
+    bool recognized;            // single cycle with a counter driven exit
+    bool exits;                 // some edge leaves the body (or it contains EOP)
+    int exitBlock;
+    bool exitTaken;             // the exit is the taken side of the branch
+    int counter, step;
+    unsigned long long minTrips, maxTrips;
+    const char *note;           // why the loop was not recognized
+} Loop;
+
+// Instruction set indexed by instruction code, NULL entries are not decoded by the CU
+const Opcode opcodes[32] = {
+    [0x01] = {"WM", OPERAND_ADDRESS},   [0x02] = {"RM", OPERAND_ADDRESS},
+    [0x03] = {"BR", OPERAND_ADDRESS},   [0x04] = {"RIO", OPERAND_ADDRESS},
+    [0x05] = {"WIO", OPERAND_ADDRESS},  [0x06] = {"WB", OPERAND_DATA},
+    [0x07] = {"WIB", OPERAND_DATA},     [0x08] = {"RETI", OPERAND_NONE},
+    [0x09] = {"WACC", OPERAND_NONE},    [0x0B] = {"RACC", OPERAND_NONE},
+    [0x0E] = {"SWAP", OPERAND_NONE},
+    [0x11] = {"BRLT", OPERAND_ADDRESS}, [0x12] = {"BRGT", OPERAND_ADDRESS},
+    [0x13] = {"BRNE", OPERAND_ADDRESS}, [0x14] = {"BRE", OPERAND_ADDRESS},
+    [0x15] = {"SHR", OPERAND_NONE},     [0x16] = {"SHL", OPERAND_NONE},
+    [0x17] = {"XOR", OPERAND_NONE},     [0x18] = {"NOT", OPERAND_NONE},
+    [0x19] = {"OR", OPERAND_NONE},      [0x1A] = {"AND", OPERAND_NONE},
+    [0x1B] = {"MUL", OPERAND_NONE},     [0x1D] = {"SUB", OPERAND_NONE},
+    [0x1E] = {"ADD", OPERAND_NONE},     [0x1F] = {"EOP", OPERAND_NONE}
+};
+
+// Image being analyzed
+const char *fileName;
+unsigned char memory[MEMORY_SIZE];
+unsigned char attr[MEMORY_SIZE];
+int imageSize;
+int errorCount, warningCount;
+
+// Control flow graph
+Block blocks[MAX_BLOCKS];
+int blockCount;
+int blockOf[MEMORY_SIZE];       // block index of each instruction start, -1 otherwise
+int opcodeCount[32];            // static instruction counts
+int instructionCount;
+bool reachesEOP;
+
+// Estimator
+int cellOf[MEMORY_SIZE];        // tracked cell of an address, -1 never written, -2 not tracked
+int cellAddress[MAX_CELLS];
+int varCount;
+int succBlock[MAX_BLOCKS][2];   // taken / fall-through successor block indices
+int succCount[MAX_BLOCKS];
+bool edgeLive[MAX_BLOCKS][2];   // edge is feasible after constant propagation
+bool blockLive[MAX_BLOCKS];
+State *inState;
+int idom[MAX_BLOCKS];
+int rpo[MAX_BLOCKS], rpoIndex[MAX_BLOCKS], rpoCount;
+Loop loops[MAX_LOOPS];
+unsigned char loopBody[MAX_LOOPS][MAX_BLOCKS / 8];
+int loopCount;
+int innermost[MAX_BLOCKS];      // smallest loop containing a block, -1 at top level
+bool preExit[MAX_BLOCKS];       // block sits before the exit branch of its loop's cycle
+bool irreducible;
+
+// Options
+bool printListing = false;
+bool printGraph = false;
+bool printEstimate = false;
+int entryPoints[MAX_ENTRIES];   // interrupt handlers, reachable besides 0x000
+int entryCount = 0;
+bool strict = false;
+
+/*===============================================
+ *   FUNCTION PROTOTYPES
+ *==============================================*/
+bool loadImage(const char *path);
+void analyze(void);
+void traceReachable(void);
+void buildBlocks(void);
+void checkImage(void);
+void report(void);
+void listing(void);
+void graph(void);
+void diagnostic(bool isError, int address, const char *fmt, ...);
+bool isPatched(int address);
+
+// Decode prototypes
+unsigned int fetch(int address);
+bool isBranch(unsigned int inst_code);
+bool isConditional(unsigned int inst_code);
+int successors(int address, int *succ);
+unsigned int instructionCycles(unsigned int inst_code);
+
+// Estimator prototypes
+void estimate(void);
+void trackCells(void);
+void initialState(State *s);
+void execute(State *s, int address, Value *test);
+void executeBlock(State *s, int b, Value *test);
+void aluOperation(State *s, unsigned int inst_code);
+Value arithmetic(Value a, Value b, bool subtract);
+bool conditionHolds(unsigned int inst_code, unsigned int t);
+bool joinState(State *dst, const State *src);
+void propagateConstants(void);
+void computeDominators(void);
+bool dominates(int a, int b);
+void findLoops(void);
+void analyzeLoop(int l);
+void havocLoop(State *s, int l);
+unsigned long long tripCount(unsigned int start, int step, unsigned int inst_code, bool exitTaken);
+void blockFrequency(int b, unsigned long long *minF, unsigned long long *maxF, bool *must);
+unsigned long long addSat(unsigned long long a, unsigned long long b);
+unsigned long long mulSat(unsigned long long a, unsigned long long b);
+void printLoopsAndEstimate(void);
+
+/*===============================================
+*   FUNCTION    :   MAIN
+*   DESCRIPTION :   Analyzes every image given on the command line.
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 if every image passed, 1 otherwise)
+ *==============================================*/
+int main(int argc, char *argv[])
+{
+    int i, images = 0, rejected = 0;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-d") == 0)
+            printListing = true;
+        else if(strcmp(argv[i], "-g") == 0)
+            printGraph = true;
+        else if(strcmp(argv[i], "-e") == 0)
+            printEstimate = true;
+        else if(strcmp(argv[i], "-s") == 0)
+            strict = true;
+        else if(strcmp(argv[i], "-v") == 0 && i + 1 < argc && entryCount < MAX_ENTRIES)
+            entryPoints[entryCount++] = (int)(strtol(argv[++i], NULL, 0) & (MEMORY_SIZE - 1) & ~1);
+        else if(argv[i][0] == '-')
+        {
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    for(i = 1; i < argc; i++)
+    {
+        if(argv[i][0] == '-')
+        {
+            i += strcmp(argv[i], "-v") == 0; // skip the address
+            continue;
+        }
+        images++;
+        fileName = argv[i];
+        if(!loadImage(fileName))
+        {
+            rejected++;
+            continue;
+        }
+        analyze();
+        if(printListing)
+            listing();
+        else if(printGraph)
+            graph();
+        else
+            report();
+        if(printEstimate)
+            estimate();
+        if(!printListing && !printGraph) // after the estimator, whose warnings count too
+            printf("  %d error(s), %d warning(s)\n", errorCount, warningCount);
+        if(errorCount > 0 || (strict && warningCount > 0))
+            rejected++;
+    }
+
+    if(images == 0)
+    {
+        fprintf(stderr, "Usage: %s [-d] [-g] [-e] [-s] [-v address] image.bin ...\n", argv[0]);
+        fprintf(stderr, "  -d  print the disassembly (can be fed back to the assembler)\n");
+        fprintf(stderr, "  -g  print the control flow graph in Graphviz dot format\n");
+        fprintf(stderr, "  -e  estimate loop bounds, executed instructions and cycles\n");
+        fprintf(stderr, "  -s  strict, reject images that have warnings\n");
+        fprintf(stderr, "  -v  interrupt handler address, traced like the entry at 0x000\n");
+        return 1;
+    }
+    return rejected ? 1 : 0;
+}
+
+/*===============================================
+*   FUNCTION    :   loadImage
+*   DESCRIPTION :   Reads a binary image, byte n of the file being address n.
+*   ARGUMENTS   :   const char *path
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool loadImage(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+
+    if(fp == NULL)
+    {
+        fprintf(stderr, "%s: cannot open file\n", path);
+        return false;
+    }
+    memset(memory, 0, sizeof(memory));
+    imageSize = (int)fread(memory, 1, sizeof(memory), fp);
+    if(fgetc(fp) != EOF)
+    {
+        fprintf(stderr, "%s: image is larger than the %d byte main memory\n", path, MEMORY_SIZE);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    return true;
+}
+
+/*===============================================
+*   FUNCTION    :   analyze
+*   DESCRIPTION :   Runs every analysis pass over the loaded image.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void analyze(void)
+{
+    memset(attr, 0, sizeof(attr));
+    memset(opcodeCount, 0, sizeof(opcodeCount));
+    errorCount = warningCount = 0;
+    instructionCount = 0;
+    reachesEOP = false;
+
+    traceReachable();
+    buildBlocks();
+    checkImage();
+}
+
+/*===============================================
+*   FUNCTION    :   fetch
+*   DESCRIPTION :   Fetches the 16-bit instruction at address (upper byte first).
+*   ARGUMENTS   :   int address
+*   RETURNS     :   UNSIGNED INT (IR)
+ *==============================================*/
+unsigned int fetch(int address)
+{
+    return (unsigned int)(memory[address] << 8 | memory[address + 1]);
+}
+
+/*===============================================
+*   FUNCTION    :   isBranch / isConditional
+*   DESCRIPTION :   Branch classification of an instruction code.
+*   ARGUMENTS   :   UNSIGNED INT inst_code
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool isBranch(unsigned int inst_code)
+{
+    return inst_code == OP_BR || isConditional(inst_code);
+}
+
+bool isConditional(unsigned int inst_code)
+{
+    return inst_code >= OP_BRLT && inst_code <= OP_BRE;
+}
+
+/*===============================================
+*   FUNCTION    :   successors
+*   DESCRIPTION :   Lists the addresses the CU can execute after the instruction
+*                   at address. Unknown instruction codes fall through, since
+*                   CU() has no case for them and simply moves on.
+*   ARGUMENTS   :   int address, int *succ (room for 2)
+*   RETURNS     :   INT (number of successors)
+ *==============================================*/
+int successors(int address, int *succ)
+{
+    unsigned int IR = fetch(address);
+    unsigned int inst_code = IR >> 11, operand = IR & OPERAND_MASK;
+    int n = 0;
+
+    if(inst_code == OP_EOP || inst_code == OP_RETI)
+        return 0; // RETI goes back to wherever the interrupt came
+    if(isBranch(inst_code))
+        succ[n++] = (int)operand;
+    if(inst_code != OP_BR)
+        succ[n++] = address + 2;
+    return n;
+}
+
+/*===============================================
+*   FUNCTION    :   instructionCycles
+*   DESCRIPTION :   Simulated cycles of an instruction: 2 fetch cycles (upper and
+*                   lower byte) plus the execute cycles of TRACS figure 4, which
+*                   are 2 for ALU operations (BUS <- MBR, ACC <- ACC op BUS) and
+*                   1 for data movement and branches. Unknown codes only fetch.
+*   ARGUMENTS   :   UNSIGNED INT inst_code
+*   RETURNS     :   UNSIGNED INT
+ *==============================================*/
+unsigned int instructionCycles(unsigned int inst_code)
+{
+    if(opcodes[inst_code].name == NULL)
+        return 2;
+    if(inst_code == OP_WACC || inst_code == OP_RACC || (inst_code >= OP_BRLT && inst_code <= OP_ADD))
+        return 4;
+    return 3;
+}
+
+/*===============================================
+*   FUNCTION    :   traceReachable
+*   DESCRIPTION :   Walks every path from PC = 0x000 and the interrupt handlers
+*                   given with -v, and marks the reachable instructions, their
+*                   targets and the data they access.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void traceReachable(void)
+{
+    int stack[MEMORY_SIZE + 1 + MAX_ENTRIES], top = 0;
+    int succ[2], n, i, address;
+    unsigned int IR, inst_code, operand;
+
+    stack[top++] = 0;
+    attr[0] |= BYTE_LEADER;
+    for(i = 0; i < entryCount; i++)
+    {
+        stack[top++] = entryPoints[i];
+        attr[entryPoints[i]] |= BYTE_LEADER;
+    }
+    while(top > 0)
+    {
+        address = stack[--top];
+        if(attr[address] & BYTE_START)
+            continue;
+        if(address + 1 >= MEMORY_SIZE)
+        {
+            diagnostic(true, address, "execution runs past the end of main memory");
+            continue;
+        }
+        if((attr[address] & BYTE_CODE) || (attr[address + 1] & BYTE_START))
+            diagnostic(true, address, "instruction overlaps another reachable instruction");
+
+        attr[address] |= BYTE_START | BYTE_CODE;
+        attr[address + 1] |= BYTE_CODE;
+        IR = fetch(address);
+        inst_code = IR >> 11;
+        operand = IR & OPERAND_MASK;
+        instructionCount++;
+        opcodeCount[inst_code]++;
+
+        if(opcodes[inst_code].name == NULL)
+            diagnostic(true, address, "invalid instruction code 0x%02x (IR 0x%04x)", inst_code, IR);
+        else if(opcodes[inst_code].kind == OPERAND_NONE && operand != 0)
+            diagnostic(false, address, "%s has unused operand bits set (0x%03x)",
+                       opcodes[inst_code].name, operand);
+        if(inst_code == OP_EOP)
+            reachesEOP = true;
+        else if(inst_code == OP_RM)
+            attr[operand] |= BYTE_READ;
+        else if(inst_code == OP_WM)
+            attr[operand] |= BYTE_WRITTEN;
+
+        n = successors(address, succ);
+        for(i = 0; i < n; i++)
+        {
+            if(succ[i] >= MEMORY_SIZE)
+            {
+                diagnostic(true, address, "execution runs past the end of main memory");
+                continue;
+            }
+            if(isBranch(inst_code))
+                attr[succ[i]] |= BYTE_LEADER;
+            if(isBranch(inst_code) && succ[i] == (int)operand)
+                attr[succ[i]] |= BYTE_TARGET;
+            stack[top++] = succ[i];
+        }
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   buildBlocks
+*   DESCRIPTION :   Splits the reachable instructions into basic blocks. A block
+*                   starts at the entry, at a branch target or after a branch,
+*                   and ends at a branch, EOP, RETI or before the next leader.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void buildBlocks(void)
+{
+    int address, next, succ[2], n, i;
+    Block *block = NULL;
+
+    blockCount = 0;
+    for(address = 0; address < MEMORY_SIZE; address++)
+        blockOf[address] = -1;
+
+    for(address = 0; address < MEMORY_SIZE; address++)
+    {
+        if(!(attr[address] & BYTE_START))
+            continue;
+        if(block == NULL || (attr[address] & BYTE_LEADER))
+        {
+            block = &blocks[blockCount++];
+            block->start = address;
+            block->count = 0;
+            block->nsucc = 0;
+        }
+        blockOf[address] = blockCount - 1;
+        block->last = address;
+        block->count++;
+
+        n = successors(address, succ);
+        next = address + 2;
+        // the block ends unless the only successor is the next instruction and it is not a leader
+        if(n == 1 && succ[0] == next && next < MEMORY_SIZE && (attr[next] & BYTE_START)
+           && !(attr[next] & BYTE_LEADER))
+            continue;
+        for(i = 0; i < n; i++)
+            if(succ[i] < MEMORY_SIZE)
+                block->succ[block->nsucc++] = succ[i];
+        block = NULL;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   checkImage
+*   DESCRIPTION :   Flags writes into the code region, unreachable bytes and
+*                   programs that can never reach EOP. A WM into the lower
+*                   byte of an RM or WM is an operand patch, the way a loop
+*                   indexes memory without indexed addressing: it only moves
+*                   the access within its 256 byte page (opcode and operand
+*                   bits 10 - 8 are in the upper byte), so it is accepted and
+*                   the access is taken to reach the whole page. Any other
+*                   write into code is an error.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void checkImage(void)
+{
+    int address, start, page, i;
+    unsigned int inst_code;
+    bool codeInPage;
+
+    for(address = 1; address < MEMORY_SIZE; address++)
+    {
+        inst_code = memory[address - 1] >> 3;
+        if((attr[address] & BYTE_WRITTEN) && (attr[address - 1] & BYTE_START)
+           && (inst_code == OP_RM || inst_code == OP_WM))
+            attr[address] |= BYTE_PATCHED;
+    }
+    for(address = 0; address < MEMORY_SIZE; address++)
+        if((attr[address] & BYTE_WRITTEN) && (attr[address] & BYTE_CODE) && !(attr[address] & BYTE_PATCHED))
+            diagnostic(true, address, "WM writes into the code region (self-modifying program)");
+
+    for(address = 0; address < MEMORY_SIZE; address++)
+    {
+        if(!(attr[address] & BYTE_START) || !isPatched(address))
+            continue;
+        page = (int)(fetch(address) & PAGE_MASK);
+        codeInPage = false;
+        for(i = page; i < page + 0x100; i++)
+        {
+            if((fetch(address) >> 11) == OP_RM)
+                attr[i] |= BYTE_READ;
+            else if(attr[i] & BYTE_CODE)
+                codeInPage = true;
+            else
+                attr[i] |= BYTE_MAY_WRITE;
+        }
+        if(codeInPage)
+            diagnostic(false, address, "patched WM can write anywhere in 0x%03x - 0x%03x, which holds code",
+                       page, page + 0xFF);
+    }
+
+    for(address = 0; address < imageSize; address++)
+    {
+        if(memory[address] == 0 || (attr[address] & (BYTE_CODE | BYTE_READ | BYTE_WRITTEN | BYTE_MAY_WRITE)))
+            continue;
+        start = address;
+        while(address + 1 < imageSize && memory[address + 1] != 0
+              && !(attr[address + 1] & (BYTE_CODE | BYTE_READ | BYTE_WRITTEN | BYTE_MAY_WRITE)))
+            address++;
+        diagnostic(false, start, "bytes 0x%03x - 0x%03x are unreachable and never accessed by RM/WM",
+                   start, address);
+    }
+
+    if(!reachesEOP)
+        diagnostic(false, 0, "no EOP is reachable, the program never terminates");
+}
+
+/*===============================================
+*   FUNCTION    :   diagnostic
+*   DESCRIPTION :   Prints an error or warning for an address of the image.
+*   ARGUMENTS   :   bool isError, int address, const char *fmt, ...
+*   RETURNS     :   VOID
+ *==============================================*/
+void diagnostic(bool isError, int address, const char *fmt, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "%s:0x%03x: %s: ", fileName, address, isError ? "error" : "warning");
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+    if(isError)
+        errorCount++;
+    else
+        warningCount++;
+}
+
+/*===============================================
+*   FUNCTION    :   isPatched
+*   DESCRIPTION :   Whether the instruction at address has its operand patched.
+*   ARGUMENTS   :   int address
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool isPatched(int address)
+{
+    return address + 1 < MEMORY_SIZE && (attr[address + 1] & BYTE_PATCHED);
+}
+
+/*===============================================
+*   FUNCTION    :   report
+*   DESCRIPTION :   Prints the static instruction counts and the basic blocks
+*                   (main() prints the totals of the diagnostics after them).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void report(void)
+{
+    int i, j, codeBytes = 0, branches = 0;
+
+    for(i = 0; i < MEMORY_SIZE; i++)
+        if(attr[i] & BYTE_CODE)
+            codeBytes++;
+    for(i = 0; i < 32; i++)
+        if(isBranch((unsigned int)i))
+            branches += opcodeCount[i];
+
+    printf("%s: %d bytes, %d reachable instructions (%d code bytes), %d branches, %d blocks\n",
+           fileName, imageSize, instructionCount, codeBytes, branches, blockCount);
+    printf("  Instruction counts:");
+    for(i = 0, j = 0; i < 32; i++)
+    {
+        if(opcodeCount[i] == 0)
+            continue;
+        printf("%s %s=%d", j++ % 8 == 0 ? "\n   " : "", opcodes[i].name ? opcodes[i].name : "???",
+               opcodeCount[i]);
+    }
+    printf("\n  Blocks:\n");
+    for(i = 0; i < blockCount; i++)
+    {
+        printf("    0x%03x - 0x%03x  %3d inst ->", blocks[i].start, blocks[i].last, blocks[i].count);
+        if(blocks[i].nsucc == 0)
+            printf(" end");
+        for(j = 0; j < blocks[i].nsucc; j++)
+            printf(" 0x%03x", blocks[i].succ[j]);
+        printf("\n");
+    }
+    for(i = 0, j = 0; i < MEMORY_SIZE; i++)
+    {
+        if(!(attr[i] & BYTE_START) || !isPatched(i))
+            continue;
+        printf("%s %s@0x%03x", j++ % 6 == 0 ? (j == 1 ? "  Patched operands:\n   " : "\n   ") : "",
+               opcodes[fetch(i) >> 11].name, i);
+    }
+    if(j > 0)
+        printf("\n");
+}
+
+/*===============================================
+*   FUNCTION    :   listing
+*   DESCRIPTION :   Prints the image as assembler source. Reachable instructions
+*                   are disassembled, other non-zero bytes become DB statements,
+*                   and a DB of the last byte keeps trailing zeros, so the
+*                   output assembles back to the same image.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void listing(void)
+{
+    unsigned int IR, inst_code, operand;
+    int address = 0, expected = -1, n;
+
+    printf("; %s\n", fileName);
+    while(address < imageSize)
+    {
+        if(!(attr[address] & BYTE_START) && memory[address] == 0
+           && !(attr[address] & (BYTE_READ | BYTE_WRITTEN)))
+        {
+            address++;
+            continue;
+        }
+        if(address != expected)
+            printf("        ORG     0x%03x\n", address);
+
+        if(attr[address] & BYTE_TARGET)
+            printf("L%03X:\n", address);
+        if(attr[address] & BYTE_START)
+        {
+            IR = fetch(address);
+            inst_code = IR >> 11;
+            operand = IR & OPERAND_MASK;
+            if(opcodes[inst_code].name == NULL
+               || (opcodes[inst_code].kind == OPERAND_NONE && operand != 0))
+                printf("        DW      0x%04x              ; 0x%03x\n", IR, address);
+            else if(opcodes[inst_code].kind == OPERAND_NONE)
+                printf("        %-7s                     ; 0x%03x\n", opcodes[inst_code].name, address);
+            else if(isBranch(inst_code))
+                printf("        %-7s L%03X                ; 0x%03x\n", opcodes[inst_code].name, operand, address);
+            else
+                printf("        %-7s 0x%03x               ; 0x%03x\n", opcodes[inst_code].name, operand, address);
+            address += 2;
+        }
+        else
+        {
+            // data: up to 8 bytes per line, stopping at the next instruction
+            printf("        DB      0x%02x", memory[address]);
+            for(n = 1, address++; n < 8 && address < imageSize && !(attr[address] & (BYTE_START | BYTE_TARGET))
+                && (memory[address] != 0 || (attr[address] & (BYTE_READ | BYTE_WRITTEN))); n++, address++)
+                printf(", 0x%02x", memory[address]);
+            printf("\n");
+        }
+        expected = address;
+    }
+    if(expected < imageSize)
+    {
+        // zeros at the end of the image are skipped above, its last byte keeps the size
+        if(expected != imageSize - 1)
+            printf("        ORG     0x%03x\n", imageSize - 1);
+        printf("        DB      0x00\n");
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   graph
+*   DESCRIPTION :   Prints the control flow graph in Graphviz dot format.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void graph(void)
+{
+    unsigned int IR;
+    int i, j, address;
+
+    printf("digraph \"%s\" {\n    node [shape=box, fontname=monospace];\n", fileName);
+    for(i = 0; i < blockCount; i++)
+    {
+        printf("    b%03x [label=\"", blocks[i].start);
+        for(address = blocks[i].start; address <= blocks[i].last; address += 2)
+        {
+            IR = fetch(address);
+            if(opcodes[IR >> 11].name == NULL)
+                printf("0x%03x: ??? 0x%04x\\l", address, IR);
+            else if(opcodes[IR >> 11].kind == OPERAND_NONE)
+                printf("0x%03x: %s\\l", address, opcodes[IR >> 11].name);
+            else
+                printf("0x%03x: %s 0x%03x\\l", address, opcodes[IR >> 11].name, IR & OPERAND_MASK);
+        }
+        printf("\"];\n");
+        for(j = 0; j < blocks[i].nsucc; j++)
+            printf("    b%03x -> b%03x;\n", blocks[i].start, blocks[i].succ[j]);
+    }
+    printf("}\n");
+}
+
+/*===============================================
+*   FUNCTION    :   estimate
+*   DESCRIPTION :   Static estimate of how long the program runs. Constant
+*                   propagation prunes branches whose outcome is fixed, natural
+*                   loops are found from the dominator tree, and loops whose
+*                   exit test follows a counter (a variable changed by a
+*                   constant step every iteration) get an exact trip count.
+*                   Block frequencies then give lower and upper bounds on the
+*                   executed instructions and cycles.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void estimate(void)
+{
+    int b, i, n, succ[2];
+
+    for(b = 0; b < blockCount; b++)
+    {
+        n = successors(blocks[b].last, succ);
+        succCount[b] = 0;
+        for(i = 0; i < n; i++)
+            if(succ[i] < MEMORY_SIZE && blockOf[succ[i]] >= 0)
+                succBlock[b][succCount[b]++] = blockOf[succ[i]];
+    }
+
+    trackCells();
+    inState = calloc((size_t)(blockCount > 0 ? blockCount : 1), sizeof(State));
+    if(inState == NULL)
+    {
+        fprintf(stderr, "%s: out of memory\n", fileName);
+        return;
+    }
+    propagateConstants();
+    computeDominators();
+    findLoops();
+    for(i = 0; i < loopCount; i++)  // loops are sorted innermost first
+        analyzeLoop(i);
+    printLoopsAndEstimate();
+    free(inState);
+}
+
+/*===============================================
+*   FUNCTION    :   trackCells
+*   DESCRIPTION :   Assigns an estimator variable to every memory cell a
+*                   reachable WM writes. Cells that are never written keep
+*                   their image value for the whole run.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void trackCells(void)
+{
+    int address, cells = 0;
+
+    for(address = 0; address < MEMORY_SIZE; address++)
+    {
+        cellOf[address] = -1;
+        if(attr[address] & BYTE_MAY_WRITE)
+            cellOf[address] = -2; // a patched WM may write it, the estimator gives up on it
+        if(!(attr[address] & BYTE_WRITTEN))
+            continue;
+        if(cells < MAX_CELLS)
+        {
+            cellAddress[cells] = address;
+            cellOf[address] = cells++;
+        }
+        else
+            cellOf[address] = -2;
+    }
+    varCount = VAR_CELLS + cells;
+}
+
+/*===============================================
+*   FUNCTION    :   initialState
+*   DESCRIPTION :   Machine state when CU() starts: registers and ACC are zero,
+*                   memory holds the image.
+*   ARGUMENTS   :   State *s
+*   RETURNS     :   VOID
+ *==============================================*/
+void initialState(State *s)
+{
+    int i;
+
+    s->accHigh.kind = VAL_CONST;
+    s->accHigh.value = 0;
+    for(i = 0; i < varCount; i++)
+    {
+        s->v[i].kind = VAL_CONST;
+        s->v[i].var = 0;
+        s->v[i].value = i >= VAR_CELLS ? memory[cellAddress[i - VAR_CELLS]] : 0;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   execute
+*   DESCRIPTION :   Applies one instruction to an abstract state, following the
+*                   data paths of CU() and ALU(). Compare-branches store the
+*                   difference ACC - BUS in *test.
+*   ARGUMENTS   :   State *s, int address, Value *test
+*   RETURNS     :   VOID
+ *==============================================*/
+void execute(State *s, int address, Value *test)
+{
+    unsigned int IR = fetch(address);
+    unsigned int inst_code = IR >> 11, operand = IR & OPERAND_MASK;
+    Value *acc = &s->v[VAR_ACC], *mbr = &s->v[VAR_MBR], *iobr = &s->v[VAR_IOBR], temp;
+    int i;
+
+    switch(inst_code)
+    {
+        case OP_WM:
+            if(isPatched(address))
+            {
+                for(i = 0; i < varCount - VAR_CELLS; i++) // the cell it writes is not known
+                    if((cellAddress[i] & PAGE_MASK) == (int)(operand & PAGE_MASK))
+                        s->v[VAR_CELLS + i].kind = VAL_UNKNOWN;
+            }
+            else if(cellOf[operand] >= 0)
+                s->v[VAR_CELLS + cellOf[operand]] = *mbr;
+            break;
+        case OP_RM:
+            if(isPatched(address))
+                mbr->kind = VAL_UNKNOWN;
+            else if(cellOf[operand] >= 0)
+                *mbr = s->v[VAR_CELLS + cellOf[operand]];
+            else if(cellOf[operand] == -1)
+            {
+                mbr->kind = VAL_CONST;
+                mbr->value = memory[operand];
+            }
+            else
+                mbr->kind = VAL_UNKNOWN;
+            break;
+        case OP_RIO:
+            iobr->kind = VAL_UNKNOWN; // input port
+            break;
+        case OP_WB:
+        case OP_WIB:
+            temp.kind = VAL_CONST;
+            temp.var = 0;
+            temp.value = operand & 0xFF; // only the low byte ever reaches the BUS
+            *(inst_code == OP_WB ? mbr : iobr) = temp;
+            break;
+        case OP_WACC:
+            *acc = *mbr;
+            break;
+        case OP_RACC:
+            *mbr = *acc;
+            break;
+        case OP_SWAP:
+            temp = *mbr;
+            *mbr = *iobr;
+            *iobr = temp;
+            break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_BRLT:
+        case OP_BRGT:
+        case OP_BRNE:
+        case OP_BRE:
+            *acc = arithmetic(*acc, *mbr, inst_code != OP_ADD);
+            s->accHigh.kind = VAL_CONST;
+            s->accHigh.value = 0;
+            if(isConditional(inst_code) && test != NULL)
+                *test = *acc;
+            break;
+        case OP_SHR:
+        case OP_SHL:
+        case OP_XOR:
+        case OP_NOT:
+        case OP_OR:
+        case OP_AND:
+        case OP_MUL:
+            aluOperation(s, inst_code);
+            break;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   executeBlock
+*   DESCRIPTION :   Applies every instruction of a basic block.
+*   ARGUMENTS   :   State *s, int b, Value *test
+*   RETURNS     :   VOID
+ *==============================================*/
+void executeBlock(State *s, int b, Value *test)
+{
+    int address;
+
+    for(address = blocks[b].start; address <= blocks[b].last; address += 2)
+        execute(s, address, test);
+}
+
+/*===============================================
+*   FUNCTION    :   aluOperation
+*   DESCRIPTION :   Logical, shift and multiply operations. They are only
+*                   evaluated on constants, anything else becomes unknown.
+*   ARGUMENTS   :   State *s, UNSIGNED INT inst_code
+*   RETURNS     :   VOID
+ *==============================================*/
+void aluOperation(State *s, unsigned int inst_code)
+{
+    Value *acc = &s->v[VAR_ACC];
+    unsigned int ACC = s->accHigh.value | acc->value, BUS = s->v[VAR_MBR].value & 0xFF;
+    bool usesBus = inst_code != OP_NOT && inst_code != OP_SHL && inst_code != OP_SHR;
+    bool usesHigh = inst_code != OP_MUL && inst_code != OP_AND;
+
+    if(acc->kind != VAL_CONST || (usesHigh && s->accHigh.kind != VAL_CONST)
+       || (usesBus && s->v[VAR_MBR].kind != VAL_CONST))
+    {
+        acc->kind = VAL_UNKNOWN;
+        s->accHigh.kind = inst_code == OP_AND ? VAL_CONST : VAL_UNKNOWN; // BUS is 8 bits wide
+        s->accHigh.value = 0;
+        return;
+    }
+
+    switch(inst_code)
+    {
+        case OP_MUL: ACC = (unsigned int)((signed char)(ACC & 0xFF) * (signed char)BUS) & 0xFFFF; break;
+        case OP_AND: ACC = ACC & BUS; break;
+        case OP_OR: ACC = ACC | BUS; break;
+        case OP_XOR: ACC = ACC ^ BUS; break;
+        case OP_NOT: ACC = ~ACC; break;
+        case OP_SHL: ACC = ACC << 1; break;
+        case OP_SHR: ACC = ACC >> 1; break;
+    }
+    acc->value = ACC & 0xFF;
+    s->accHigh.kind = VAL_CONST;
+    s->accHigh.value = ACC & ~0xFFu;
+}
+
+/*===============================================
+*   FUNCTION    :   arithmetic
+*   DESCRIPTION :   8-bit addition or subtraction of abstract values. A counter
+*                   plus or minus a constant stays affine in that counter.
+*   ARGUMENTS   :   Value a, Value b, bool subtract
+*   RETURNS     :   Value
+ *==============================================*/
+Value arithmetic(Value a, Value b, bool subtract)
+{
+    Value r = {VAL_UNKNOWN, 0, 0};
+
+    if(a.kind == VAL_CONST && b.kind == VAL_CONST)
+        r.kind = VAL_CONST;
+    else if(a.kind == VAL_AFFINE && b.kind == VAL_CONST)
+    {
+        r.kind = VAL_AFFINE;
+        r.var = a.var;
+    }
+    else if(!subtract && a.kind == VAL_CONST && b.kind == VAL_AFFINE)
+    {
+        r.kind = VAL_AFFINE;
+        r.var = b.var;
+    }
+    else if(subtract && a.kind == VAL_AFFINE && b.kind == VAL_AFFINE && a.var == b.var)
+        r.kind = VAL_CONST;
+    else
+        return r;
+    r.value = (subtract ? a.value - b.value : a.value + b.value) & 0xFF;
+    return r;
+}
+
+/*===============================================
+*   FUNCTION    :   conditionHolds
+*   DESCRIPTION :   Branch condition of a compare-branch on the difference
+*                   t = ACC - BUS (BRLT SF=1, BRGT SF=0, BRNE ZF=0, BRE ZF=1).
+*   ARGUMENTS   :   UNSIGNED INT inst_code, UNSIGNED INT t
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool conditionHolds(unsigned int inst_code, unsigned int t)
+{
+    t &= 0xFF;
+    switch(inst_code)
+    {
+        case OP_BRLT: return (t & 0x80) != 0;
+        case OP_BRGT: return (t & 0x80) == 0;
+        case OP_BRNE: return t != 0;
+        default: return t == 0;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   joinState
+*   DESCRIPTION :   Merges src into dst (values that differ become unknown).
+*   ARGUMENTS   :   State *dst, const State *src
+*   RETURNS     :   BOOL (dst changed)
+ *==============================================*/
+bool joinState(State *dst, const State *src)
+{
+    bool changed = false;
+    int i;
+
+    for(i = -1; i < varCount; i++)
+    {
+        Value *d = i < 0 ? &dst->accHigh : &dst->v[i];
+        const Value *v = i < 0 ? &src->accHigh : &src->v[i];
+        if(d->kind == VAL_UNKNOWN || v->kind == VAL_TOP)
+            continue;
+        if(d->kind == VAL_TOP)
+            *d = *v;
+        else if(d->kind == v->kind && d->var == v->var && d->value == v->value)
+            continue;
+        else
+            d->kind = VAL_UNKNOWN;
+        changed = true;
+    }
+    return changed;
+}
+
+/*===============================================
+*   FUNCTION    :   propagateConstants
+*   DESCRIPTION :   Forward constant propagation over the CFG. A branch whose
+*                   compare is constant only keeps the edge it actually takes.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void propagateConstants(void)
+{
+    int work[MAX_BLOCKS], top = 0, b, i, s;
+    bool queued[MAX_BLOCKS];
+    unsigned int inst_code;
+    State state;
+    Value test;
+
+    for(b = 0; b < blockCount; b++)
+    {
+        blockLive[b] = queued[b] = false;
+        edgeLive[b][0] = edgeLive[b][1] = false;
+    }
+    if(blockCount == 0)
+        return;
+
+    initialState(&inState[0]);
+    blockLive[0] = queued[0] = true;
+    work[top++] = 0;
+    while(top > 0)
+    {
+        b = work[--top];
+        queued[b] = false;
+        state = inState[b];
+        test.kind = VAL_UNKNOWN;
+        executeBlock(&state, b, &test);
+
+        inst_code = fetch(blocks[b].last) >> 11;
+        for(i = 0; i < succCount[b]; i++)
+        {
+            // edge 0 is the taken side of a compare-branch, edge 1 the fall-through
+            if(isConditional(inst_code) && test.kind == VAL_CONST
+               && conditionHolds(inst_code, test.value) != (i == 0))
+                continue;
+            s = succBlock[b][i];
+            edgeLive[b][i] = true;
+            if((joinState(&inState[s], &state) || !blockLive[s]) && !queued[s])
+            {
+                queued[s] = true;
+                work[top++] = s;
+            }
+            blockLive[s] = true;
+        }
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   computeDominators
+*   DESCRIPTION :   Immediate dominators over the live edges (Cooper, Harvey and
+*                   Kennedy's iterative algorithm on the reverse postorder).
+*                   Also detects retreating edges to non-dominators, which
+*                   make the control flow irreducible.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void computeDominators(void)
+{
+    int stack[MAX_BLOCKS], next[MAX_BLOCKS], top = 0, b, i, p, s, a, c, newIdom;
+    unsigned char state[MAX_BLOCKS]; // 0 unvisited, 1 on the DFS stack, 2 finished
+    bool changed = true;
+    int order[MAX_BLOCKS], count = 0;
+
+    irreducible = false;
+    for(b = 0; b < blockCount; b++)
+    {
+        state[b] = 0;
+        idom[b] = -1;
+        rpoIndex[b] = -1;
+    }
+    rpoCount = 0;
+    if(blockCount == 0)
+        return;
+
+    // iterative DFS for the postorder
+    stack[top++] = 0;
+    next[0] = 0;
+    state[0] = 1;
+    while(top > 0)
+    {
+        b = stack[top - 1];
+        if(next[b] < succCount[b])
+        {
+            i = next[b]++;
+            s = succBlock[b][i];
+            if(edgeLive[b][i] && state[s] == 0)
+            {
+                state[s] = 1;
+                next[s] = 0;
+                stack[top++] = s;
+            }
+            continue;
+        }
+        state[b] = 2;
+        order[count++] = b;
+        top--;
+    }
+    for(i = 0; i < count; i++)
+    {
+        rpo[i] = order[count - 1 - i];
+        rpoIndex[rpo[i]] = i;
+    }
+    rpoCount = count;
+
+    idom[0] = 0;
+    while(changed)
+    {
+        changed = false;
+        for(i = 1; i < rpoCount; i++)
+        {
+            b = rpo[i];
+            newIdom = -1;
+            for(p = 0; p < blockCount; p++)
+            {
+                for(c = 0; c < succCount[p]; c++)
+                {
+                    if(!edgeLive[p][c] || succBlock[p][c] != b || idom[p] < 0)
+                        continue;
+                    if(newIdom < 0)
+                        newIdom = p;
+                    else
+                    {
+                        a = p;
+                        s = newIdom;
+                        while(a != s)
+                        {
+                            while(rpoIndex[a] > rpoIndex[s])
+                                a = idom[a];
+                            while(rpoIndex[s] > rpoIndex[a])
+                                s = idom[s];
+                        }
+                        newIdom = a;
+                    }
+                }
+            }
+            if(newIdom >= 0 && idom[b] != newIdom)
+            {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    // an edge to a block that comes earlier in the RPO but does not dominate the source
+    for(b = 0; b < blockCount; b++)
+        for(i = 0; i < succCount[b]; i++)
+            if(edgeLive[b][i] && rpoIndex[b] >= 0 && rpoIndex[succBlock[b][i]] <= rpoIndex[b]
+               && !dominates(succBlock[b][i], b))
+                irreducible = true;
+}
+
+/*===============================================
+*   FUNCTION    :   dominates
+*   DESCRIPTION :   Checks whether every path from the entry to b passes a.
+*   ARGUMENTS   :   int a, int b
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool dominates(int a, int b)
+{
+    if(idom[b] < 0)
+        return false;
+    while(b != a && b != 0)
+        b = idom[b];
+    return b == a;
+}
+
+/*===============================================
+*   FUNCTION    :   findLoops
+*   DESCRIPTION :   Builds the natural loop of every back edge (an edge to a
+*                   dominator), merging loops that share a header, then sorts
+*                   them innermost first and links each to its parent.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void findLoops(void)
+{
+    int stack[MAX_BLOCKS], top, b, h, i, j, l, p, c, x;
+    unsigned char bodyTemp[MAX_BLOCKS / 8];
+    Loop temp;
+
+    loopCount = 0;
+    for(b = 0; b < blockCount; b++)
+    {
+        innermost[b] = -1;
+        preExit[b] = false;
+    }
+
+    for(b = 0; b < blockCount; b++)
+    {
+        for(i = 0; i < succCount[b]; i++)
+        {
+            h = succBlock[b][i];
+            if(!edgeLive[b][i] || !dominates(h, b))
+                continue;
+            for(l = 0; l < loopCount && loops[l].header != h; l++)
+                ;
+            if(l == loopCount)
+            {
+                if(loopCount == MAX_LOOPS)
+                {
+                    diagnostic(false, blocks[h].start, "more than %d loops, estimate is incomplete", MAX_LOOPS);
+                    irreducible = true;
+                    continue;
+                }
+                loopCount++;
+                memset(&loops[l], 0, sizeof(Loop));
+                memset(loopBody[l], 0, sizeof(loopBody[l]));
+                loops[l].header = h;
+                loops[l].parent = -1;
+                loops[l].exitBlock = -1;
+                loopBody[l][h >> 3] |= (unsigned char)(1 << (h & 7));
+            }
+            // walk backwards from the latch until the header
+            top = 0;
+            if(!(loopBody[l][b >> 3] & (1 << (b & 7))))
+            {
+                loopBody[l][b >> 3] |= (unsigned char)(1 << (b & 7));
+                stack[top++] = b;
+            }
+            while(top > 0)
+            {
+                x = stack[--top];
+                for(p = 0; p < blockCount; p++)
+                    for(c = 0; c < succCount[p]; c++)
+                        if(edgeLive[p][c] && succBlock[p][c] == x && !(loopBody[l][p >> 3] & (1 << (p & 7))))
+                        {
+                            loopBody[l][p >> 3] |= (unsigned char)(1 << (p & 7));
+                            stack[top++] = p;
+                        }
+            }
+        }
+    }
+
+    for(l = 0; l < loopCount; l++)
+    {
+        loops[l].size = 0;
+        loops[l].last = blocks[loops[l].header].last;
+        for(b = 0; b < blockCount; b++)
+            if(loopBody[l][b >> 3] & (1 << (b & 7)))
+            {
+                loops[l].size++;
+                if(blocks[b].last > loops[l].last)
+                    loops[l].last = blocks[b].last;
+            }
+    }
+
+    // innermost first (insertion sort on size, bodies move along)
+    for(i = 1; i < loopCount; i++)
+        for(j = i; j > 0 && loops[j].size < loops[j - 1].size; j--)
+        {
+            temp = loops[j];
+            loops[j] = loops[j - 1];
+            loops[j - 1] = temp;
+            memcpy(bodyTemp, loopBody[j], sizeof(bodyTemp));
+            memcpy(loopBody[j], loopBody[j - 1], sizeof(bodyTemp));
+            memcpy(loopBody[j - 1], bodyTemp, sizeof(bodyTemp));
+        }
+
+    for(l = 0; l < loopCount; l++)
+    {
+        h = loops[l].header;
+        for(j = l + 1; j < loopCount; j++)
+            if(loopBody[j][h >> 3] & (1 << (h & 7)))
+            {
+                loops[l].parent = j;
+                break;
+            }
+        for(b = 0; b < blockCount; b++)
+            if(innermost[b] < 0 && (loopBody[l][b >> 3] & (1 << (b & 7))))
+                innermost[b] = l;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   analyzeLoop
+*   DESCRIPTION :   Tries to bound a loop. The body, with inner loops collapsed
+*                   to single nodes, has to be one cycle with a single exiting
+*                   compare-branch. One iteration is executed symbolically from
+*                   the header; if the compared value is a counter plus a
+*                   constant, and the counter changes by a constant step, the
+*                   trip count follows from its value on entry.
+*   ARGUMENTS   :   int l
+*   RETURNS     :   VOID
+ *==============================================*/
+void analyzeLoop(int l)
+{
+    Loop *loop = &loops[l];
+    int node, next, visited = 0, nodes = 0, b, i, k, x, target, inTarget, exitEdges, entries = 0;
+    bool pre = true, seen[MAX_BLOCKS];
+    unsigned int inst_code, start, value;
+    unsigned long long n;
+    State state, entry;
+    Value test = {VAL_UNKNOWN, 0, 0};
+
+    loop->recognized = false;
+    loop->minTrips = 0;
+    loop->maxTrips = UNBOUNDED;
+    loop->note = "body is not a single cycle";
+
+    // does anything leave the loop at all?
+    loop->exits = false;
+    for(b = 0; b < blockCount; b++)
+    {
+        if(!(loopBody[l][b >> 3] & (1 << (b & 7))))
+            continue;
+        if(succCount[b] == 0)
+            loop->exits = true; // EOP or the end of memory
+        for(i = 0; i < succCount[b]; i++)
+            if(edgeLive[b][i] && !(loopBody[l][succBlock[b][i] >> 3] & (1 << (succBlock[b][i] & 7))))
+                loop->exits = true;
+    }
+    if(!loop->exits)
+    {
+        loop->note = "no path leaves the loop";
+        loop->minTrips = UNBOUNDED;
+        return;
+    }
+
+    // nodes of the cycle are blocks whose innermost loop is l, and child loops
+    for(b = 0; b < blockCount; b++)
+    {
+        seen[b] = false;
+        if(innermost[b] == l)
+            nodes++;
+    }
+    for(k = 0; k < l; k++)
+        if(loops[k].parent == l)
+            nodes++;
+
+    initialState(&state);
+    for(i = 0; i < varCount; i++)
+    {
+        state.v[i].kind = VAL_AFFINE;
+        state.v[i].var = (short)i;
+        state.v[i].value = 0;
+    }
+    state.accHigh.kind = VAL_UNKNOWN;
+
+    node = loop->header;
+    exitEdges = 0;
+    while(true)
+    {
+        seen[node] = true;
+        visited++;
+        inTarget = -1;
+        k = innermost[node];
+        if(k != l)
+        {
+            // collapsed child loop: climb to the child of l that contains this header
+            while(loops[k].parent != l)
+                k = loops[k].parent;
+            loops[k].preInParent = pre;
+            havocLoop(&state, k);
+            for(b = 0; b < blockCount; b++)
+            {
+                if(!(loopBody[k][b >> 3] & (1 << (b & 7))))
+                    continue;
+                for(i = 0; i < succCount[b]; i++)
+                {
+                    target = succBlock[b][i];
+                    if(!edgeLive[b][i] || (loopBody[k][target >> 3] & (1 << (target & 7))))
+                        continue;
+                    if(!(loopBody[l][target >> 3] & (1 << (target & 7))) || (inTarget >= 0 && inTarget != target))
+                        return; // the inner loop leaves both loops, or has several exits
+                    inTarget = target;
+                }
+            }
+        }
+        else
+        {
+            preExit[node] = pre;
+            executeBlock(&state, node, node == loop->exitBlock || loop->exitBlock < 0 ? &test : NULL);
+            for(i = 0; i < succCount[node]; i++)
+            {
+                target = succBlock[node][i];
+                if(!edgeLive[node][i])
+                    continue;
+                if(!(loopBody[l][target >> 3] & (1 << (target & 7))))
+                {
+                    inst_code = fetch(blocks[node].last) >> 11;
+                    if(++exitEdges > 1 || !isConditional(inst_code))
+                        return;
+                    loop->exitBlock = node;
+                    loop->exitTaken = i == 0;
+                    pre = false;
+                }
+                else if(inTarget >= 0 && inTarget != target)
+                    return; // branches inside the body
+                else
+                    inTarget = target;
+            }
+        }
+        if(inTarget < 0)
+            return;
+
+        // the next node is a block of l or the header of a child loop
+        next = inTarget;
+        if(innermost[next] != l && loops[innermost[next]].header != next)
+            return;
+        if(next == loop->header)
+            break;
+        if(seen[next])
+            return;
+        node = next;
+    }
+    if(visited != nodes || exitEdges != 1)
+        return;
+
+    // value of every variable when the loop is entered from outside
+    memset(&entry, 0, sizeof(entry));
+    if(loop->header == 0)
+    {
+        initialState(&state);
+        joinState(&entry, &state);
+        entries++;
+    }
+    for(b = 0; b < blockCount; b++)
+    {
+        if(loopBody[l][b >> 3] & (1 << (b & 7)))
+            continue;
+        for(i = 0; i < succCount[b]; i++)
+        {
+            if(!edgeLive[b][i] || succBlock[b][i] != loop->header)
+                continue;
+            state = inState[b];
+            executeBlock(&state, b, NULL);
+            joinState(&entry, &state);
+            entries++;
+        }
+    }
+    if(entries == 0)
+        return;
+
+    // redo the symbolic iteration now that the exit block is known
+    initialState(&state);
+    for(i = 0; i < varCount; i++)
+    {
+        state.v[i].kind = VAL_AFFINE;
+        state.v[i].var = (short)i;
+        state.v[i].value = 0;
+    }
+    state.accHigh.kind = VAL_UNKNOWN;
+    test.kind = VAL_UNKNOWN;
+    node = loop->header;
+    do
+    {
+        if(innermost[node] == l)
+        {
+            executeBlock(&state, node, node == loop->exitBlock ? &test : NULL);
+            for(i = 0; i < succCount[node]; i++)
+                if(edgeLive[node][i] && (loopBody[l][succBlock[node][i] >> 3] & (1 << (succBlock[node][i] & 7))))
+                    next = succBlock[node][i];
+        }
+        else
+        {
+            for(k = innermost[node]; loops[k].parent != l; k = loops[k].parent)
+                ;
+            havocLoop(&state, k);
+            for(b = 0; b < blockCount; b++)
+                if(loopBody[k][b >> 3] & (1 << (b & 7)))
+                    for(i = 0; i < succCount[b]; i++)
+                        if(edgeLive[b][i] && !(loopBody[k][succBlock[b][i] >> 3] & (1 << (succBlock[b][i] & 7))))
+                            next = succBlock[b][i];
+        }
+        node = next;
+    } while(node != loop->header);
+
+    inst_code = fetch(blocks[loop->exitBlock].last) >> 11;
+    loop->counter = -1;
+    loop->step = 0;
+    if(test.kind == VAL_CONST)
+    {
+        // the same comparison every iteration
+        loop->recognized = true;
+        loop->note = NULL;
+        if(conditionHolds(inst_code, test.value) == loop->exitTaken)
+            loop->minTrips = loop->maxTrips = 0;
+        else
+            loop->minTrips = loop->maxTrips = UNBOUNDED;
+        return;
+    }
+    if(test.kind != VAL_AFFINE)
+    {
+        loop->note = "exit test does not depend on a counter";
+        return;
+    }
+    x = test.var;
+    if(state.v[x].kind != VAL_AFFINE || state.v[x].var != x)
+    {
+        loop->note = "counter is not changed by a constant step";
+        return;
+    }
+    loop->counter = x;
+    loop->step = (int)(signed char)state.v[x].value;
+    loop->recognized = true;
+    loop->note = NULL;
+
+    if(entry.v[x].kind == VAL_CONST)
+    {
+        start = (entry.v[x].value + test.value) & 0xFF;
+        loop->minTrips = loop->maxTrips = tripCount(start, loop->step, inst_code, loop->exitTaken);
+        return;
+    }
+    // unknown start value: bound over every possible 8-bit value
+    for(value = 0; value < 256; value++)
+    {
+        n = tripCount((value + test.value) & 0xFF, loop->step, inst_code, loop->exitTaken);
+        if(value == 0 || n < loop->minTrips)
+            loop->minTrips = n;
+        if(value == 0 || n > loop->maxTrips)
+            loop->maxTrips = n;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   havocLoop
+*   DESCRIPTION :   Forgets every variable a loop writes (used when an inner
+*                   loop is collapsed into a single node of its parent).
+*   ARGUMENTS   :   State *s, int l
+*   RETURNS     :   VOID
+ *==============================================*/
+void havocLoop(State *s, int l)
+{
+    int b, address, i;
+    unsigned int IR, inst_code;
+
+    for(b = 0; b < blockCount; b++)
+    {
+        if(!(loopBody[l][b >> 3] & (1 << (b & 7))))
+            continue;
+        for(address = blocks[b].start; address <= blocks[b].last; address += 2)
+        {
+            IR = fetch(address);
+            inst_code = IR >> 11;
+            if(inst_code == OP_WM && isPatched(address))
+            {
+                for(i = 0; i < varCount - VAR_CELLS; i++)
+                    if((cellAddress[i] & PAGE_MASK) == (int)(IR & PAGE_MASK))
+                        s->v[VAR_CELLS + i].kind = VAL_UNKNOWN;
+            }
+            else if(inst_code == OP_WM && cellOf[IR & OPERAND_MASK] >= 0)
+                s->v[VAR_CELLS + cellOf[IR & OPERAND_MASK]].kind = VAL_UNKNOWN;
+            else if(inst_code == OP_RM || inst_code == OP_WB || inst_code == OP_RACC)
+                s->v[VAR_MBR].kind = VAL_UNKNOWN;
+            else if(inst_code == OP_RIO || inst_code == OP_WIB)
+                s->v[VAR_IOBR].kind = VAL_UNKNOWN;
+            else if(inst_code == OP_SWAP)
+                s->v[VAR_MBR].kind = s->v[VAR_IOBR].kind = VAL_UNKNOWN;
+            else if(inst_code == OP_WACC || (inst_code >= OP_BRLT && inst_code <= OP_ADD))
+                s->v[VAR_ACC].kind = s->accHigh.kind = VAL_UNKNOWN;
+        }
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   tripCount
+*   DESCRIPTION :   Number of back edges taken before the exit, for a compared
+*                   value starting at start and changing by step. All values are
+*                   8 bits wide, so the sequence repeats after 256 iterations.
+*   ARGUMENTS   :   UNSIGNED INT start, int step, UNSIGNED INT inst_code, bool exitTaken
+*   RETURNS     :   UNSIGNED LONG LONG (UNBOUNDED if the loop never exits)
+ *==============================================*/
+unsigned long long tripCount(unsigned int start, int step, unsigned int inst_code, bool exitTaken)
+{
+    unsigned int i, t = start;
+
+    for(i = 0; i < 256; i++)
+    {
+        if(conditionHolds(inst_code, t) == exitTaken)
+            return i;
+        t = (t + (unsigned int)step) & 0xFF;
+    }
+    return UNBOUNDED;
+}
+
+/*===============================================
+*   FUNCTION    :   blockFrequency
+*   DESCRIPTION :   How often a block runs, multiplied over its enclosing loops.
+*                   In a recognized loop the blocks up to the exit branch run
+*                   trips + 1 times, the ones after it trips times; in any other
+*                   loop only the header is known to run (at least once).
+*                   *must tells whether the block runs on every terminating path.
+*   ARGUMENTS   :   int b, unsigned long long *minF, unsigned long long *maxF, bool *must
+*   RETURNS     :   VOID
+ *==============================================*/
+void blockFrequency(int b, unsigned long long *minF, unsigned long long *maxF, bool *must)
+{
+    int l = innermost[b], node = b, e;
+    bool pre = preExit[b], atHeader = l >= 0 && loops[l].header == b;
+    bool anyExit = false;
+    Loop *loop;
+
+    *minF = *maxF = 1;
+    *must = true;
+    while(l >= 0)
+    {
+        loop = &loops[l];
+        if(loop->recognized)
+        {
+            *minF = mulSat(*minF, addSat(loop->minTrips, pre ? 1 : 0));
+            *maxF = mulSat(*maxF, addSat(loop->maxTrips, pre ? 1 : 0));
+        }
+        else
+        {
+            if(!atHeader)
+            {
+                *minF = 0;
+                *must = false;
+            }
+            *maxF = UNBOUNDED;
+        }
+        node = loop->header;
+        pre = loop->preInParent;
+        atHeader = false; // a child loop is never the header node of its parent
+        l = loop->parent;
+    }
+
+    // at top level the block (or its outermost loop) must dominate every EOP
+    for(e = 0; e < blockCount; e++)
+    {
+        if(!blockLive[e] || succCount[e] != 0 || (fetch(blocks[e].last) >> 11) != OP_EOP)
+            continue;
+        anyExit = true;
+        if(!dominates(node, e))
+            *must = false;
+    }
+    if(!anyExit)
+        *must = false;
+}
+
+/*===============================================
+*   FUNCTION    :   addSat / mulSat
+*   DESCRIPTION :   Saturating arithmetic, UNBOUNDED being infinity.
+*   ARGUMENTS   :   UNSIGNED LONG LONG a, b
+*   RETURNS     :   UNSIGNED LONG LONG
+ *==============================================*/
+unsigned long long addSat(unsigned long long a, unsigned long long b)
+{
+    return a > UNBOUNDED - b ? UNBOUNDED : a + b;
+}
+
+unsigned long long mulSat(unsigned long long a, unsigned long long b)
+{
+    if(a == 0 || b == 0)
+        return 0;
+    return a > UNBOUNDED / b ? UNBOUNDED : a * b;
+}
+
+/*===============================================
+*   FUNCTION    :   printLoopsAndEstimate
+*   DESCRIPTION :   Prints every loop with its bound and the estimated number
+*                   of executed instructions and cycles. A loop the analysis
+*                   cannot bound (several paths through the body, a counter
+*                   it does not follow) has an unknown bound, which is not a
+*                   warning; only loops that are shown to possibly never exit
+*                   are. The upper estimate is then unknown rather than
+*                   unbounded.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void printLoopsAndEstimate(void)
+{
+    unsigned long long minF, maxF, minInst = 0, maxInst = 0, minCycles = 0, maxCycles = 0, cycles;
+    int l, b, address;
+    bool must, terminates = false, endless = false;
+    Loop *loop;
+    char counter[16];
+    const char *bound;
+
+    if(loopCount > 0)
+        printf("  Loops:\n");
+    for(l = 0; l < loopCount; l++)
+    {
+        loop = &loops[l];
+        printf("    0x%03x - 0x%03x  ", blocks[loop->header].start, loop->last);
+        if(!loop->exits)
+        {
+            printf("never exits\n");
+            diagnostic(false, blocks[loop->header].start, "infinite loop, no path leaves it");
+            endless = true;
+            continue;
+        }
+        if(!loop->recognized)
+        {
+            printf("unknown bound: %s\n", loop->note);
+            continue;
+        }
+        if(loop->counter < 0)
+            printf("constant exit test");
+        else
+        {
+            if(loop->counter == VAR_ACC)
+                strcpy(counter, "ACC");
+            else if(loop->counter == VAR_MBR)
+                strcpy(counter, "MBR");
+            else if(loop->counter == VAR_IOBR)
+                strcpy(counter, "IOBR");
+            else
+                sprintf(counter, "[0x%03x]", cellAddress[loop->counter - VAR_CELLS]);
+            printf("counter %s step %+d", counter, loop->step);
+        }
+        printf(", exit %s at 0x%03x: ", opcodes[fetch(blocks[loop->exitBlock].last) >> 11].name,
+               blocks[loop->exitBlock].last);
+        if(loop->maxTrips == UNBOUNDED)
+        {
+            printf("%s\n", loop->minTrips == UNBOUNDED ? "never exits" : "may never exit");
+            diagnostic(false, blocks[loop->header].start, "%s infinite loop, the counter can miss the exit value",
+                       loop->minTrips == UNBOUNDED ? "an" : "possible");
+            endless = true;
+        }
+        else if(loop->minTrips == loop->maxTrips)
+            printf("%llu iterations\n", loop->maxTrips);
+        else
+            printf("%llu - %llu iterations\n", loop->minTrips, loop->maxTrips);
+    }
+
+    for(b = 0; b < blockCount; b++)
+    {
+        if(!blockLive[b])
+            continue;
+        if(succCount[b] == 0 && (fetch(blocks[b].last) >> 11) == OP_EOP)
+            terminates = true;
+        blockFrequency(b, &minF, &maxF, &must);
+        if(irreducible)
+            maxF = UNBOUNDED;
+        cycles = 0;
+        for(address = blocks[b].start; address <= blocks[b].last; address += 2)
+            cycles += instructionCycles(fetch(address) >> 11);
+        maxInst = addSat(maxInst, mulSat(maxF, (unsigned long long)blocks[b].count));
+        maxCycles = addSat(maxCycles, mulSat(maxF, cycles));
+        if(must)
+        {
+            minInst = addSat(minInst, mulSat(minF, (unsigned long long)blocks[b].count));
+            minCycles = addSat(minCycles, mulSat(minF, cycles));
+        }
+    }
+    if(irreducible)
+        diagnostic(false, 0, "irreducible control flow, no upper bound");
+    if(!terminates)
+    {
+        maxInst = maxCycles = UNBOUNDED;
+        endless = true;
+    }
+    bound = endless ? "unbounded" : "unknown"; // what an UNBOUNDED maximum means
+
+    printf("  Estimate: instructions %llu - ", minInst);
+    if(maxInst == UNBOUNDED)
+        printf("%s", bound);
+    else
+        printf("%llu", maxInst);
+    printf(", cycles %llu - ", minCycles);
+    if(maxCycles == UNBOUNDED)
+        printf("%s", bound);
+    else
+        printf("%llu", maxCycles);
+    printf(" (%s)\n", maxInst == UNBOUNDED ? (endless ? "unbounded" : "upper bound unknown")
+                      : minInst == maxInst ? "exact" : "bounded");
+}
@@ -0,0 +1,647 @@
+ /*======================================================================================================
+* FILE        : FaultCampaign.c
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : Fault injection campaigns on program images. A golden run of the image records
+*               snapshots of the machine; every injection starts from the last snapshot before its
+*               cycle, flips bits in a chip cell (A1..B8), in ACC or on BUS, and runs to EOP or a
+*               budget. Outcomes are masked (same outputs), wrong output, hang (budget) or crash
+*               (an invalid instruction is reached). An injection whose state comes back to the
+*               golden one at a snapshot is masked without running further. Injections are shared
+*               by a pool of worker threads. The CU follows CU() of LE6, the ALU, cycle model and
+*               branch conditions are those of CORE/Core.h, which LE6 runs as well; of the IO
+*               devices only the seven segment output and an input stream without input are modeled.
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+*   19 October, 2026: V1.1 - ALU, Booth's algorithm, cycles and branch conditions from CORE/Core.h
+======================================================================================================*/
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#include "../CORE/Core.h"
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define MAX_SNAPSHOTS 1024      // of the golden run, evenly spaced in instructions
+#define MAX_THREADS 64
+#define DEFAULT_INJECTIONS 10000
+#define DEFAULT_GOLDEN_BUDGET 100000000ull
+#define HANG_FACTOR 2           // a faulty run gets twice the golden instructions, plus the slack
+#define HANG_SLACK 1000
+
+// IO (addresses in CORE/Core.h): every write to IO_SEGMENT is an output, the input stream
+// has no input (no byte, end of input) and the input latches read as 0
+
+// Machine status
+#define RUNNING 0
+#define STOPPED_EOP 1
+#define STOPPED_INVALID 2       // fetched an unused instruction code or RETI outside a handler
+
+// Fault locations
+#define LOC_MEMORY 0            // a cell of chips A1 - A8 (0x000 - 0x3FF) or B1 - B8
+#define LOC_ACC 1
+#define LOC_BUS 2
+#define LOC_KINDS 3
+
+// Outcomes
+#define MASKED 0
+#define WRONG_OUTPUT 1
+#define HANG 2
+#define CRASH 3
+#define OUTCOMES 4
+
+typedef struct
+{
+    unsigned char memory[MEMORY_SIZE];
+    unsigned int pc, acc, mbr, iobr, flags; // ACC is 32 bits wide like in LE6
+    unsigned char bus;
+    int status;
+    unsigned long long instructions, cycles, outputs, outputHash;
+} Machine;
+
+typedef struct
+{
+    unsigned long long cycle;   // injected before the first instruction starting at or after it
+    int kind;
+    unsigned int address;       // LOC_MEMORY only
+    unsigned int mask;          // bits flipped
+    int outcome;
+} Injection;
+
+/*===============================================
+ *   GLOBAL VARIABLES
+ *==============================================*/
+Machine golden;                 // state at the end of the golden run
+Machine snapshots[MAX_SNAPSHOTS];
+int snapshotCount = 0;
+unsigned long long snapshotInterval = 1; // instructions between two snapshots
+unsigned long long goldenBudget = DEFAULT_GOLDEN_BUDGET;
+
+Injection *injections = NULL;
+long injectionCount = DEFAULT_INJECTIONS;
+long nextInjection = 0;         // next one a worker takes
+int bitsPerFault = 1, threadCount = 4;
+bool locationEnabled[LOC_KINDS] = {true, true, true};
+unsigned int memoryFrom = 0, memoryTo = MEMORY_SIZE - 1;
+unsigned long long seed = 1;
+const char *csvPath = NULL;
+#ifndef _WIN32
+pthread_mutex_t injectionLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+const char *outcomeNames[OUTCOMES] = {"masked", "wrong output", "hang", "crash"};
+const char *locationNames[LOC_KINDS] = {"memory", "ACC", "BUS"};
+
+/*===============================================
+ *   FUNCTION PROTOTYPES
+ *==============================================*/
+bool loadImage(const char *path, Machine *m);
+bool goldenRun(void);
+void planInjections(void);
+unsigned long long nextRandom(void);
+void runCampaign(void);
+void *worker(void *arg);
+void inject(Injection *fault);
+void report(double seconds);
+void describeLocation(const Injection *fault, char *text, size_t size);
+bool parseRange(const char *text, unsigned int *from, unsigned int *to);
+double wallClock(void);
+
+// CU
+void step(Machine *m);
+unsigned int physical(unsigned int address);
+bool sameState(const Machine *a, const Machine *b);
+
+/*===============================================
+*   FUNCTION    :   MAIN
+*   DESCRIPTION :   Runs the golden run, plans the injections, runs them on the
+*                   worker threads and prints the outcomes.
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 if the campaign ran, 1 on errors)
+ *==============================================*/
+int main(int argc, char *argv[])
+{
+    const char *image = NULL, *p;
+    double start;
+    int i;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            injectionCount = strtol(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+            bitsPerFault = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            threadCount = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 0) | 1;
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            goldenBudget = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            if(!parseRange(argv[++i], &memoryFrom, &memoryTo))
+            {
+                fprintf(stderr, "Bad memory range '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+        {
+            p = argv[++i];
+            locationEnabled[LOC_MEMORY] = strstr(p, "memory") != NULL || strcmp(p, "all") == 0;
+            locationEnabled[LOC_ACC] = strstr(p, "acc") != NULL || strcmp(p, "all") == 0;
+            locationEnabled[LOC_BUS] = strstr(p, "bus") != NULL || strcmp(p, "all") == 0;
+        }
+        else if(argv[i][0] == '-' || image != NULL)
+        {
+            image = NULL;
+            break;
+        }
+        else
+            image = argv[i];
+    }
+    if(image == NULL || injectionCount <= 0 || bitsPerFault < 1 || bitsPerFault > 8 || threadCount < 1
+       || (!locationEnabled[LOC_MEMORY] && !locationEnabled[LOC_ACC] && !locationEnabled[LOC_BUS]))
+    {
+        fprintf(stderr, "Usage: %s [-n injections] [-k bits] [-l memory,acc,bus|all] [-m from-to] [-t threads]\n"
+                        "       [-s seed] [-i instructions] [-o results.csv] image.bin\n", argv[0]);
+        fprintf(stderr, "  -n  number of injections (default %d)\n", DEFAULT_INJECTIONS);
+        fprintf(stderr, "  -k  adjacent bits flipped per fault, 1 - 8 (default 1)\n");
+        fprintf(stderr, "  -l  where faults go (default all)\n");
+        fprintf(stderr, "  -m  memory addresses of the faults (default 0x000-0x7FF)\n");
+        fprintf(stderr, "  -t  worker threads (default 4)\n");
+        fprintf(stderr, "  -i  instruction budget of the golden run\n");
+        fprintf(stderr, "  -o  writes every injection and its outcome as CSV\n");
+        return 1;
+    }
+    if(threadCount > MAX_THREADS)
+        threadCount = MAX_THREADS;
+    if(!loadImage(image, &snapshots[0]) || !goldenRun())
+        return 1;
+
+    injections = calloc((size_t)injectionCount, sizeof(Injection));
+    if(injections == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return 1;
+    }
+    planInjections();
+    start = wallClock();
+    runCampaign();
+    report(wallClock() - start);
+    free(injections);
+    return 0;
+}
+
+/*===============================================
+*   FUNCTION    :   loadImage
+*   DESCRIPTION :   Reads a binary image into a reset machine, byte n of the
+*                   file being address n.
+*   ARGUMENTS   :   const char *path, Machine *m
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool loadImage(const char *path, Machine *m)
+{
+    FILE *fp = fopen(path, "rb");
+
+    if(fp == NULL)
+    {
+        fprintf(stderr, "%s: cannot open file\n", path);
+        return false;
+    }
+    memset(m, 0, sizeof(*m));
+    fread(m->memory, 1, sizeof(m->memory), fp);
+    if(fgetc(fp) != EOF)
+    {
+        fprintf(stderr, "%s: image is larger than the %d byte main memory\n", path, MEMORY_SIZE);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    return true;
+}
+
+/*===============================================
+*   FUNCTION    :   goldenRun
+*   DESCRIPTION :   Runs the image once to find its length, then again to take
+*                   MAX_SNAPSHOTS snapshots spread over the run.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   BOOL (false if the golden run does not reach EOP)
+ *==============================================*/
+bool goldenRun(void)
+{
+    golden = snapshots[0];
+    while(golden.status == RUNNING && golden.instructions < goldenBudget)
+        step(&golden);
+    if(golden.status != STOPPED_EOP)
+    {
+        fprintf(stderr, "The golden run %s after %llu instructions\n",
+                golden.status == RUNNING ? "did not reach EOP" : "reached an invalid instruction", golden.instructions);
+        return false;
+    }
+
+    snapshotInterval = golden.instructions / MAX_SNAPSHOTS + 1;
+    for(snapshotCount = 1; snapshotCount < MAX_SNAPSHOTS; snapshotCount++)
+    {
+        snapshots[snapshotCount] = snapshots[snapshotCount - 1];
+        while(snapshots[snapshotCount].status == RUNNING
+              && snapshots[snapshotCount].instructions < (unsigned long long)snapshotCount * snapshotInterval)
+            step(&snapshots[snapshotCount]);
+        if(snapshots[snapshotCount].status != RUNNING)
+            break; // the last snapshot would be the end of the run
+    }
+    printf("Golden run: %llu instructions, %llu cycles, %llu outputs, %d snapshots every %llu instructions\n",
+           golden.instructions, golden.cycles, golden.outputs, snapshotCount, snapshotInterval);
+    return true;
+}
+
+/*===============================================
+*   FUNCTION    :   planInjections
+*   DESCRIPTION :   Draws the cycle and location of every injection. A fault
+*                   of k bits flips k adjacent bits of one cell or register.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void planInjections(void)
+{
+    unsigned int width, shift;
+    long i;
+
+    for(i = 0; i < injectionCount; i++)
+    {
+        do
+            injections[i].kind = (int)(nextRandom() % LOC_KINDS);
+        while(!locationEnabled[injections[i].kind]);
+        injections[i].cycle = nextRandom() % golden.cycles;
+        width = injections[i].kind == LOC_ACC ? 16 : 8;
+        shift = (unsigned int)(nextRandom() % (width - bitsPerFault + 1));
+        injections[i].mask = ((1u << bitsPerFault) - 1) << shift;
+        if(injections[i].kind == LOC_MEMORY)
+            injections[i].address = memoryFrom + (unsigned int)(nextRandom() % (memoryTo - memoryFrom + 1));
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   nextRandom
+*   DESCRIPTION :   xorshift64*, the campaign is the same for the same -s.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   UNSIGNED LONG LONG
+ *==============================================*/
+unsigned long long nextRandom(void)
+{
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 0x2545F4914F6CDD1Dull;
+}
+
+/*===============================================
+*   FUNCTION    :   runCampaign / worker
+*   DESCRIPTION :   Starts the worker threads, each takes the next injection
+*                   until none are left. Without pthreads (Windows) the
+*                   injections run on the calling thread.
+*   ARGUMENTS   :   VOID / void *arg (unused)
+*   RETURNS     :   VOID / NULL
+ *==============================================*/
+void runCampaign(void)
+{
+#ifndef _WIN32
+    pthread_t threads[MAX_THREADS];
+    int i, started = 0;
+
+    for(i = 0; i < threadCount; i++)
+        if(pthread_create(&threads[started], NULL, worker, NULL) == 0)
+            started++;
+    if(started == 0)
+        worker(NULL);
+    for(i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+#else
+    worker(NULL);
+#endif
+}
+
+void *worker(void *arg)
+{
+    long i;
+
+    (void)arg;
+    for(;;)
+    {
+#ifndef _WIN32
+        pthread_mutex_lock(&injectionLock);
+#endif
+        i = nextInjection++;
+#ifndef _WIN32
+        pthread_mutex_unlock(&injectionLock);
+#endif
+        if(i >= injectionCount)
+            return NULL;
+        inject(&injections[i]);
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   inject
+*   DESCRIPTION :   Runs one injection from the last snapshot before its cycle
+*                   and classifies it. At every later snapshot the state is
+*                   compared with the golden run, the same state means the
+*                   fault was masked.
+*   ARGUMENTS   :   Injection *fault
+*   RETURNS     :   VOID
+ *==============================================*/
+void inject(Injection *fault)
+{
+    Machine m;
+    unsigned long long budget = golden.instructions * HANG_FACTOR + HANG_SLACK;
+    int s = 0, lo = 0, hi = snapshotCount - 1;
+    bool sameOutputs;
+
+    while(lo <= hi) // last snapshot that starts at or before the cycle
+    {
+        int mid = (lo + hi) / 2;
+        if(snapshots[mid].cycles <= fault->cycle)
+        {
+            s = mid;
+            lo = mid + 1;
+        }
+        else
+            hi = mid - 1;
+    }
+    m = snapshots[s];
+    while(m.status == RUNNING && m.cycles < fault->cycle)
+        step(&m);
+
+    if(fault->kind == LOC_MEMORY)
+        m.memory[fault->address] ^= (unsigned char)fault->mask;
+    else if(fault->kind == LOC_ACC)
+        m.acc ^= fault->mask;
+    else
+        m.bus ^= (unsigned char)fault->mask;
+
+    while(s < snapshotCount && snapshots[s].instructions <= m.instructions)
+        s++; // the first snapshot after the injection
+    while(m.status == RUNNING && m.instructions < budget)
+    {
+        step(&m);
+        if(s < snapshotCount && m.instructions == snapshots[s].instructions)
+        {
+            if(sameState(&m, &snapshots[s]))
+            {
+                fault->outcome = MASKED; // from here it is the golden run
+                return;
+            }
+            s++;
+        }
+    }
+    sameOutputs = m.outputs == golden.outputs && m.outputHash == golden.outputHash;
+    if(m.status == STOPPED_INVALID)
+        fault->outcome = CRASH;
+    else if(m.status == RUNNING)
+        fault->outcome = HANG;
+    else
+        fault->outcome = sameOutputs ? MASKED : WRONG_OUTPUT;
+}
+
+/*===============================================
+*   FUNCTION    :   report
+*   DESCRIPTION :   Prints the outcomes per location and writes the CSV.
+*   ARGUMENTS   :   double seconds (of the campaign)
+*   RETURNS     :   VOID
+ *==============================================*/
+void report(double seconds)
+{
+    long counts[LOC_KINDS + 1][OUTCOMES], totals[LOC_KINDS + 1];
+    char location[32];
+    FILE *csv = NULL;
+    long i;
+    int k, o;
+
+    memset(counts, 0, sizeof(counts));
+    memset(totals, 0, sizeof(totals));
+    for(i = 0; i < injectionCount; i++)
+    {
+        counts[injections[i].kind][injections[i].outcome]++;
+        counts[LOC_KINDS][injections[i].outcome]++;
+        totals[injections[i].kind]++;
+        totals[LOC_KINDS]++;
+    }
+
+    printf("%-8s %10s", "", "injections");
+    for(o = 0; o < OUTCOMES; o++)
+        printf(" %14s", outcomeNames[o]);
+    printf("\n");
+    for(k = 0; k <= LOC_KINDS; k++)
+    {
+        if(totals[k] == 0)
+            continue;
+        printf("%-8s %10ld", k < LOC_KINDS ? locationNames[k] : "total", totals[k]);
+        for(o = 0; o < OUTCOMES; o++)
+            printf(" %7ld %5.1f%%", counts[k][o], 100.0 * counts[k][o] / totals[k]);
+        printf("\n");
+    }
+    if(seconds > 0)
+        printf("%ld injections in %.2f s on %d threads, %.0f injections per hour\n",
+               injectionCount, seconds, threadCount, injectionCount / seconds * 3600);
+
+    if(csvPath != NULL && (csv = fopen(csvPath, "w")) == NULL)
+        fprintf(stderr, "Error: cannot create %s\n", csvPath);
+    if(csv != NULL)
+    {
+        fprintf(csv, "cycle,location,mask,outcome\n");
+        for(i = 0; i < injectionCount; i++)
+        {
+            describeLocation(&injections[i], location, sizeof(location));
+            fprintf(csv, "%llu,%s,0x%02x,%s\n", injections[i].cycle, location, injections[i].mask,
+                    outcomeNames[injections[i].outcome]);
+        }
+        fclose(csv);
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   describeLocation
+*   DESCRIPTION :   Names the faulted cell after the chips of MainMemory():
+*                   bit 7 of a byte is in A1/B1, bit 0 in A8/B8, at the row
+*                   (ADDR >> 5) and column (ADDR & 0x1F) of the address.
+*   ARGUMENTS   :   const Injection *fault, char *text, size_t size
+*   RETURNS     :   VOID
+ *==============================================*/
+void describeLocation(const Injection *fault, char *text, size_t size)
+{
+    int bit = 0;
+
+    if(fault->kind != LOC_MEMORY)
+    {
+        snprintf(text, size, "%s", locationNames[fault->kind]);
+        return;
+    }
+    while(!((fault->mask >> bit) & 1))
+        bit++;
+    snprintf(text, size, "0x%03x %c%d r%u c%u", fault->address, fault->address < 0x400 ? 'A' : 'B',
+             8 - bit, (fault->address >> 5) & 0x1F, fault->address & 0x1F);
+}
+
+/*===============================================
+*   FUNCTION    :   parseRange
+*   DESCRIPTION :   Reads "from-to" (C number syntax) inside the main memory.
+*   ARGUMENTS   :   const char *text, UNSIGNED INT *from, UNSIGNED INT *to
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool parseRange(const char *text, unsigned int *from, unsigned int *to)
+{
+    char *end;
+
+    *from = (unsigned int)strtoul(text, &end, 0);
+    *to = *end == '-' ? (unsigned int)strtoul(end + 1, &end, 0) : *from;
+    return *end == '\0' && *from <= *to && *to < MEMORY_SIZE;
+}
+
+/*===============================================
+*   FUNCTION    :   wallClock
+*   DESCRIPTION :   Seconds of wall-clock time for the injection rate (clock()
+*                   adds up the time of every thread).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   DOUBLE
+ *==============================================*/
+double wallClock(void)
+{
+#ifndef _WIN32
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC; // a single thread there
+#endif
+}
+
+/*===============================================
+*   FUNCTION    :   step
+*   DESCRIPTION :   Fetches, decodes and executes one instruction, like one
+*                   pass of the loop in CU().
+*   ARGUMENTS   :   Machine *m
+*   RETURNS     :   VOID
+ *==============================================*/
+void step(Machine *m)
+{
+    unsigned int ir, inst_code, operand, temp;
+
+    ir = (m->memory[physical(m->pc)] << 8) | m->memory[physical(m->pc + 1)];
+    m->pc += 2;
+    inst_code = ir >> 11;
+    operand = ir & OPERAND_MASK;
+    m->instructions++;
+    m->cycles += coreCycles[inst_code];
+
+    switch(inst_code)
+    {
+        case OP_WM:
+            m->bus = (unsigned char)m->mbr;
+            m->memory[physical(operand)] = m->bus;
+            break;
+        case OP_RM:
+            m->bus = m->memory[physical(operand)];
+            m->mbr = m->bus;
+            break;
+        case OP_BR:
+            m->pc = operand;
+            break;
+        case OP_RIO:
+            if(operand == IO_INPUT_STATUS)
+                m->bus = IO_INPUT_END;
+            else if(operand == IO_INPUT_DATA || operand == IO_INPUT_COUNT
+                    || (operand >= IO_INPUT_LATCHES && operand <= IO_LAST_LATCH))
+                m->bus = 0; // other addresses leave BUS as is
+            m->iobr = m->bus;
+            break;
+        case OP_WIO:
+            m->bus = (unsigned char)m->iobr;
+            if(operand == IO_SEGMENT)
+            {
+                if(m->outputs++ == 0)
+                    m->outputHash = 0xCBF29CE484222325ull;
+                m->outputHash = (m->outputHash ^ m->bus) * 0x100000001B3ull;
+            }
+            break;
+        case OP_WB:
+            m->mbr = operand;
+            break;
+        case OP_WIB:
+            m->iobr = operand;
+            break;
+        case OP_WACC:
+            m->bus = (unsigned char)m->mbr;
+            coreALU(OP_WACC, &m->acc, &m->bus, &m->flags, coreBooth);
+            break;
+        case OP_RACC:
+            coreALU(OP_RACC, &m->acc, &m->bus, &m->flags, coreBooth);
+            m->mbr = m->bus;
+            break;
+        case OP_SWAP:
+            temp = m->iobr;
+            m->iobr = m->mbr;
+            m->mbr = temp;
+            break;
+        case OP_BRLT: case OP_BRGT: case OP_BRNE: case OP_BRE:
+            m->bus = (unsigned char)m->mbr;
+            coreALU(OP_SUB, &m->acc, &m->bus, &m->flags, coreBooth); // compare: ACC <- ACC - BUS
+            if(coreBranchTaken(inst_code, m->flags))
+                m->pc = operand;
+            break;
+        case OP_SHR: case OP_SHL: case OP_XOR: case OP_NOT: case OP_OR: case OP_AND:
+        case OP_MUL: case OP_SUB: case OP_ADD:
+            m->bus = (unsigned char)m->mbr;
+            coreALU(inst_code, &m->acc, &m->bus, &m->flags, coreBooth);
+            break;
+        case OP_EOP:
+            m->status = STOPPED_EOP;
+            break;
+        default: // unused codes, and RETI without an interrupt to return from
+            m->status = STOPPED_INVALID;
+            break;
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   physical
+*   DESCRIPTION :   Cell MainMemory() reaches for an address, an address past
+*                   0x7FF still selects chip group B (cs = ADDR >> 10 != 0).
+*   ARGUMENTS   :   UNSIGNED INT address
+*   RETURNS     :   UNSIGNED INT
+ *==============================================*/
+unsigned int physical(unsigned int address)
+{
+    return (address & 0x3FF) | ((address >> 10) ? 0x400 : 0);
+}
+
+/*===============================================
+*   FUNCTION    :   sameState
+*   DESCRIPTION :   True if two machines will run the same from here on, and
+*                   have shown the same outputs so far.
+*   ARGUMENTS   :   const Machine *a, const Machine *b
+*   RETURNS     :   BOOL
+ *==============================================*/
+bool sameState(const Machine *a, const Machine *b)
+{
+    return a->pc == b->pc && a->acc == b->acc && a->mbr == b->mbr && a->iobr == b->iobr && a->flags == b->flags
+           && a->bus == b->bus && a->status == b->status && a->outputs == b->outputs
+           && a->outputHash == b->outputHash && memcmp(a->memory, b->memory, sizeof(a->memory)) == 0;
+}
@@ -0,0 +1,362 @@
+ /*======================================================================================================
+* FILE        : MemBench.c
+* AUTHOR      : Josh Ratificar (Hardware Lead)
+*               Ben Cesar Cadungog (Software Lead)
+*               Jeddah Laine Luceñara  (Research Lead)
+*               Harold Marvin Comendador (Documentation Lead)
+* DESCRIPTION : Microbenchmark of the main memory implementations. Every backend is timed on
+*               sequential, strided and random reads and writes of the 2048 byte address space:
+*               a repetition is one timed batch of accesses, the first ones are warmup and thrown
+*               away, and the ns per access of the others are reported as min, median, p90, p99
+*               and max. The backends are the functions of CORE/Memory.h that MainMemory() of
+*               LE6 and CORE/Core.c call, compiled from the same header:
+*                 flat      flatRead()/flatWrite(), dataMemory[ADDR] of LE2 - LE5
+*                 chips     chipRead()/chipWrite(), a getBit()/setBit() per chip of LE6
+* COPYRIGHT   : 19 October, 2026
+* REVISION HISTORY:
+*   19 October, 2026: V1.0 - File Created
+*   19 October, 2026: V1.1 - Backends from CORE/Memory.h instead of copies, the planes copy is gone
+======================================================================================================*/
+/*===============================================
+ *   HEADER FILES
+ *==============================================*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "../CORE/Memory.h"
+
+/*===============================================
+ *   DEFINITIONS AND CONSTANTS
+ *==============================================*/
+#define MAX_REPETITIONS 10000
+#define DEFAULT_REPETITIONS 200
+#define DEFAULT_WARMUP 20
+#define DEFAULT_ACCESSES 65536      // per repetition
+#define DEFAULT_STRIDE 32           // the same column of the next row
+
+#define PATTERN_SEQUENTIAL 0
+#define PATTERN_STRIDED 1
+#define PATTERN_RANDOM 2
+#define PATTERNS 3
+
+typedef struct
+{
+    const char *name;
+    void (*read)(void);             // BUS <- cell at ADDR
+    void (*write)(void);            // cell at ADDR <- BUS
+} Backend;
+
+/*===============================================
+ *   GLOBAL VARIABLES
+ *==============================================*/
+unsigned char BUS = 0x00;
+unsigned int ADDR = 0x00;
+
+// flat
+unsigned char dataMemory[MEMORY_SIZE];
+
+// chips, [group A/B][chip 1 - 8][row] as in CORE/Core.c
+long chips[2][CHIP_COUNT][CHIP_ROWS];
+long *const chipGroups[2][CHIP_COUNT] =
+{
+    {chips[0][0], chips[0][1], chips[0][2], chips[0][3], chips[0][4], chips[0][5], chips[0][6], chips[0][7]},
+    {chips[1][0], chips[1][1], chips[1][2], chips[1][3], chips[1][4], chips[1][5], chips[1][6], chips[1][7]}
+};
+
+unsigned int *addresses = NULL;     // the access pattern of a repetition
+unsigned int accessCount = DEFAULT_ACCESSES;
+volatile unsigned char sink;        // keeps the reads from being optimized away
+
+const char *patternNames[PATTERNS] = {"sequential", "strided", "random"};
+
+/*===============================================
+ *   FUNCTION PROTOTYPES
+ *==============================================*/
+void flatBusRead(void);
+void flatBusWrite(void);
+void chipsBusRead(void);
+void chipsBusWrite(void);
+
+void makePattern(int pattern, unsigned int stride, unsigned long long seed);
+double timeBatch(const Backend *backend, bool write);
+int compareSeconds(const void *a, const void *b);
+double percentile(const double *sorted, int count, double p);
+double wallClock(void);
+
+const Backend backends[] =
+{
+    {"flat", flatBusRead, flatBusWrite},
+    {"chips", chipsBusRead, chipsBusWrite}
+};
+#define BACKENDS ((int)(sizeof(backends) / sizeof(backends[0])))
+
+/*===============================================
+*   FUNCTION    :   MAIN
+*   DESCRIPTION :   Times every backend on every pattern, reads then writes,
+*                   and prints a table (or JSON with -o).
+*   ARGUMENTS   :   int argc, char *argv[]
+*   RETURNS     :   INT (0 on success, 1 on errors)
+ *==============================================*/
+int main(int argc, char *argv[])
+{
+    int repetitions = DEFAULT_REPETITIONS, warmup = DEFAULT_WARMUP, b, p, w, r, kept, first = 1, i;
+    unsigned int stride = DEFAULT_STRIDE;
+    unsigned long long seed = 1;
+    const char *output = NULL, *only = NULL;
+    double *samples;
+    FILE *fp = NULL;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repetitions = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            warmup = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            accessCount = (unsigned int)strtoul(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            stride = (unsigned int)strtoul(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 0) | 1;
+        else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            only = argv[++i];
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            repetitions = 0;
+            break;
+        }
+    }
+    if(repetitions < 1 || repetitions > MAX_REPETITIONS || warmup < 0 || warmup > MAX_REPETITIONS
+       || accessCount == 0 || stride == 0)
+    {
+        fprintf(stderr, "Usage: %s [-r repetitions] [-w warmup] [-n accesses] [-s stride] [-S seed] [-b backend]\n"
+                        "       [-o results.json]\n", argv[0]);
+        fprintf(stderr, "  -r  timed repetitions of every test (default %d)\n", DEFAULT_REPETITIONS);
+        fprintf(stderr, "  -w  repetitions run first and not counted (default %d)\n", DEFAULT_WARMUP);
+        fprintf(stderr, "  -n  accesses per repetition (default %d)\n", DEFAULT_ACCESSES);
+        fprintf(stderr, "  -s  address step of the strided pattern (default %d, a row of the chips)\n", DEFAULT_STRIDE);
+        fprintf(stderr, "  -b  only this backend: flat or chips\n");
+        return 1;
+    }
+    addresses = malloc(accessCount * sizeof(unsigned int));
+    samples = malloc((size_t)repetitions * sizeof(double));
+    if(addresses == NULL || samples == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return 1;
+    }
+    if(output != NULL && (fp = fopen(output, "w")) == NULL)
+    {
+        fprintf(stderr, "%s: cannot create file\n", output);
+        return 1;
+    }
+
+    if(fp != NULL)
+        fprintf(fp, "{\n  \"accesses\": %u,\n  \"repetitions\": %d,\n  \"warmup\": %d,\n  \"stride\": %u,\n  \"results\": [\n",
+                accessCount, repetitions, warmup, stride);
+    printf("%-8s %-10s %-5s %9s %9s %9s %9s %9s   ns/access\n", "backend", "pattern", "op", "min", "p50", "p90", "p99", "max");
+    for(b = 0; b < BACKENDS; b++)
+    {
+        if(only != NULL && strcmp(only, backends[b].name) != 0)
+            continue;
+        for(p = 0; p < PATTERNS; p++)
+        {
+            makePattern(p, stride, seed);
+            for(w = 0; w <= 1; w++)
+            {
+                for(r = 0, kept = 0; r < warmup + repetitions; r++)
+                {
+                    double seconds = timeBatch(&backends[b], w);
+
+                    if(r >= warmup)
+                        samples[kept++] = seconds * 1e9 / accessCount;
+                }
+                qsort(samples, (size_t)kept, sizeof(double), compareSeconds);
+                printf("%-8s %-10s %-5s %9.2f %9.2f %9.2f %9.2f %9.2f\n", backends[b].name, patternNames[p],
+                       w ? "write" : "read", samples[0], percentile(samples, kept, 50), percentile(samples, kept, 90),
+                       percentile(samples, kept, 99), samples[kept - 1]);
+                if(fp != NULL)
+                {
+                    fprintf(fp, "%s    {\"backend\": \"%s\", \"pattern\": \"%s\", \"op\": \"%s\", \"min\": %.3f, "
+                                "\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+                            first ? "" : ",\n", backends[b].name, patternNames[p], w ? "write" : "read", samples[0],
+                            percentile(samples, kept, 50), percentile(samples, kept, 90), percentile(samples, kept, 99),
+                            samples[kept - 1]);
+                    first = 0;
+                }
+            }
+        }
+    }
+    if(fp != NULL)
+    {
+        fprintf(fp, "\n  ]\n}\n");
+        fclose(fp);
+    }
+    free(addresses);
+    free(samples);
+    return 0;
+}
+
+/*===============================================
+*   FUNCTION    :   makePattern
+*   DESCRIPTION :   Fills addresses with a pattern: 0, 1, 2 ...; 0, stride,
+*                   2 * stride ... (wrapping into the next column, so every
+*                   cell is reached); or uniformly random addresses.
+*   ARGUMENTS   :   int pattern, UNSIGNED INT stride, UNSIGNED LONG LONG seed
+*   RETURNS     :   VOID
+ *==============================================*/
+void makePattern(int pattern, unsigned int stride, unsigned long long seed)
+{
+    unsigned long long state = seed;
+    unsigned int i, address = 0;
+
+    for(i = 0; i < accessCount; i++)
+    {
+        if(pattern == PATTERN_SEQUENTIAL)
+            addresses[i] = i & ADDRESS_MASK;
+        else if(pattern == PATTERN_STRIDED)
+        {
+            addresses[i] = address;
+            address += stride;
+            if(address >= MEMORY_SIZE)
+                address = (address + 1) % MEMORY_SIZE;
+        }
+        else
+        {
+            state ^= state << 13; // xorshift64
+            state ^= state >> 7;
+            state ^= state << 17;
+            addresses[i] = (unsigned int)(state >> 32) & ADDRESS_MASK;
+        }
+    }
+}
+
+/*===============================================
+*   FUNCTION    :   timeBatch
+*   DESCRIPTION :   One repetition: reads or writes every address of the
+*                   pattern through a backend.
+*   ARGUMENTS   :   const Backend *backend, BOOL write
+*   RETURNS     :   DOUBLE (seconds)
+ *==============================================*/
+double timeBatch(const Backend *backend, bool write)
+{
+    unsigned char sum = 0;
+    unsigned int i;
+    double start = wallClock();
+
+    if(write)
+    {
+        for(i = 0; i < accessCount; i++)
+        {
+            ADDR = addresses[i];
+            BUS = (unsigned char)i;
+            backend->write();
+        }
+    }
+    else
+    {
+        for(i = 0; i < accessCount; i++)
+        {
+            ADDR = addresses[i];
+            backend->read();
+            sum += BUS;
+        }
+    }
+    sink = sum;
+    return wallClock() - start;
+}
+
+/*===============================================
+*   FUNCTION    :   flatBusRead / flatBusWrite
+*   DESCRIPTION :   MainMemory() of LE5 and of the core's MEMORY_BUS.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void flatBusRead(void)
+{
+    BUS = flatRead(dataMemory, ADDR);
+}
+
+void flatBusWrite(void)
+{
+    flatWrite(dataMemory, ADDR, BUS);
+}
+
+/*===============================================
+*   FUNCTION    :   chipsBusRead / chipsBusWrite
+*   DESCRIPTION :   MainMemory() of LE6 and of the core's MEMORY_CHIPS without
+*                   the models of LE6 (caches, row buffer, banks, heatmap).
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   VOID
+ *==============================================*/
+void chipsBusRead(void)
+{
+    BUS = chipRead(chipGroups[(ADDR >> 10) != 0], ADDR);
+}
+
+void chipsBusWrite(void)
+{
+    chipWrite(chipGroups[(ADDR >> 10) != 0], ADDR, BUS);
+}
+
+/*===============================================
+*   FUNCTION    :   compareSeconds
+*   DESCRIPTION :   qsort() order of the samples.
+*   ARGUMENTS   :   const void *a, const void *b
+*   RETURNS     :   INT
+ *==============================================*/
+int compareSeconds(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*===============================================
+*   FUNCTION    :   percentile
+*   DESCRIPTION :   Nearest-rank percentile of sorted samples.
+*   ARGUMENTS   :   const double *sorted, int count, double p (0 - 100)
+*   RETURNS     :   DOUBLE
+ *==============================================*/
+double percentile(const double *sorted, int count, double p)
+{
+    int rank = (int)(p / 100.0 * count + 0.999999);
+
+    if(rank < 1)
+        rank = 1;
+    if(rank > count)
+        rank = count;
+    return sorted[rank - 1];
+}
+
+/*===============================================
+*   FUNCTION    :   wallClock
+*   DESCRIPTION :   Seconds on a monotonic clock.
+*   ARGUMENTS   :   VOID
+*   RETURNS     :   DOUBLE
+ *==============================================*/
+double wallClock(void)
+{
+#ifndef _WIN32
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#else
+    LARGE_INTEGER now, frequency;
+
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    return (double)now.QuadPart / frequency.QuadPart;
+#endif
+}